@@ -3,6 +3,7 @@
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "esp_sleep.h"
 #include "driver/gpio.h"
 #include "user_config.h"
 
@@ -31,9 +32,32 @@ static void on_pwr_longpress_press(Button* btn_handle);
 static void on_pwr_pressup_press(Button* btn_handle);
 /*********************************************/
 
+/*
+ * 5ms 扫描定时器只在按键活动期间运行: 按下时由低电平中断启动, 两个键都松开且状态机回到空闲后停止,
+ * 平时没有周期定时器, 不妨碍 light sleep 和 tickless idle.
+ */
+static esp_timer_handle_t clock_tick_timer = NULL;
+
 static void clock_task_callback(void *arg)
 {
   	button_ticks();              //状态回调
+  	if (button1.state != BTN_STATE_IDLE || button2.state != BTN_STATE_IDLE ||
+  	  	gpio_get_level(USER_KEY_1) == button1_active || gpio_get_level(USER_KEY_2) == button2_active)
+  	{
+  	  	return;
+  	}
+  	esp_timer_stop(clock_tick_timer);
+  	//电平触发: 停止扫描后若又被按下, 重新打开中断时立刻再进中断, 不会漏掉按键
+  	gpio_intr_enable(USER_KEY_1);
+  	gpio_intr_enable(USER_KEY_2);
+}
+
+static void button_isr_handler(void *arg)
+{
+  	//扫描期间屏蔽按键中断, 低电平会一直触发
+  	gpio_intr_disable(USER_KEY_1);
+  	gpio_intr_disable(USER_KEY_2);
+  	esp_timer_start_periodic(clock_tick_timer, 1000 * TICKS_INTERVAL);
 }
 static uint8_t read_button_GPIO(uint8_t button_id)   //返回GPIO电平
 {
@@ -52,13 +76,18 @@ static uint8_t read_button_GPIO(uint8_t button_id)   //返回GPIO电平
 static void gpio_init(void)
 {
   	gpio_config_t gpio_conf = {};
-  	gpio_conf.intr_type = GPIO_INTR_DISABLE;
+  	gpio_conf.intr_type = GPIO_INTR_LOW_LEVEL;     //按键低电平有效
   	gpio_conf.mode = GPIO_MODE_INPUT;
   	gpio_conf.pin_bit_mask = (0x1ULL<<USER_KEY_1) | (0x1ULL<<USER_KEY_2);
   	gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
   	gpio_conf.pull_up_en = GPIO_PULLUP_ENABLE;
 
   	ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_config(&gpio_conf));
+
+  	//light sleep 中按下按键也能唤醒
+  	ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_wakeup_enable(USER_KEY_1, GPIO_INTR_LOW_LEVEL));
+  	ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_wakeup_enable(USER_KEY_2, GPIO_INTR_LOW_LEVEL));
+  	ESP_ERROR_CHECK_WITHOUT_ABORT(esp_sleep_enable_gpio_wakeup());
 }
 
 void user_button_init(void)
@@ -82,11 +111,17 @@ void user_button_init(void)
   	  	clock_tick_timer_args.callback = &clock_task_callback;
   	  	clock_tick_timer_args.name = "clock_task";
   	  	clock_tick_timer_args.arg = NULL;
-  	esp_timer_handle_t clock_tick_timer = NULL;
-  	ESP_ERROR_CHECK(esp_timer_create(&clock_tick_timer_args, &clock_tick_timer));
-  	ESP_ERROR_CHECK(esp_timer_start_periodic(clock_tick_timer, 1000 * 5));  //5ms
+  	ESP_ERROR_CHECK(esp_timer_create(&clock_tick_timer_args, &clock_tick_timer));  //由按键中断启动
   	button_start(&button2); //启动按键
   	button_start(&button1); //启动按键
+
+  	esp_err_t ret = gpio_install_isr_service(0);
+  	if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)   //ISR 服务可能已被其他模块安装
+  	{
+  	  	ESP_ERROR_CHECK_WITHOUT_ABORT(ret);
+  	}
+  	ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_isr_handler_add(USER_KEY_1, button_isr_handler, NULL));
+  	ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_isr_handler_add(USER_KEY_2, button_isr_handler, NULL));
 }
 
 
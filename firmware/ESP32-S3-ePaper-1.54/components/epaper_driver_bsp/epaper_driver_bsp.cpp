@@ -1,182 +1,175 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include "freertos/FreeRTOS.h"
 #include "epaper_driver_bsp.h"
+#include "epaper_pack.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "epaper_transport_spi.h"
+#endif
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "esp_heap_caps.h" 
 
 static const char *TAG = "driver";
 
-const uint8_t WF_Full_1IN54[159] =
-{											
-    0x80,	0x48,	0x40,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
-    0x40,	0x48,	0x80,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
-    0x80,	0x48,	0x40,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
-    0x40,	0x48,	0x80,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
-    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
-    0xA,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x8,	0x1,	0x0,	0x8,	0x1,	0x0,	0x2,					
-    0xA,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
-    0x22,	0x22,	0x22,	0x22,	0x22,	0x22,	0x0,	0x0,	0x0,			
-    0x22,	0x17,	0x41,	0x0,	0x32,	0x20
-};
-
-unsigned char WF_PARTIAL_1IN54_0[159] =
-{
-    0x0,0x40,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x80,0x80,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x40,0x40,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x80,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0xF,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x1,0x1,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
-    0x22,0x22,0x22,0x22,0x22,0x22,0x0,0x0,0x0,
-    0x02,0x17,0x41,0xB0,0x32,0x28,
-};
-
-epaper_driver_display::epaper_driver_display(int width, int height,custom_lcd_spi_t _lcd_spi_data) : 
-    lcd_spi_data(_lcd_spi_data),
-    Width(width),
-    Height(height) {
-
-    ESP_LOGI(TAG, "Initialize SPI");
-	spi_port_init();
-	spi_gpio_init();
-
-    buffer = (uint8_t *)heap_caps_malloc(lcd_spi_data.buffer_len, MALLOC_CAP_SPIRAM);
+#if !CONFIG_IDF_TARGET_LINUX
+template <typename Panel>
+epaper_driver<Panel>::epaper_driver(custom_lcd_spi_t _lcd_spi_data) :
+    epaper_driver(new epaper_transport_spi(_lcd_spi_data, Width * Height)) {
+    own_io = true;
+}
+#endif
+
+template <typename Panel>
+epaper_driver<Panel>::epaper_driver(epaper_transport *transport) :
+    io(transport) {
+
+    bus_mux = xSemaphoreCreateRecursiveMutex();
+    job_mux = xSemaphoreCreateMutex();
+    refresh_done_sem = xSemaphoreCreateBinary();
+    assert(io && bus_mux && job_mux && refresh_done_sem);
+
+    buffer = (uint8_t *)heap_caps_malloc(buffer_len, MALLOC_CAP_SPIRAM);
 	assert(buffer);
+    shown = (uint8_t *)heap_caps_malloc(buffer_len, MALLOC_CAP_INTERNAL);
+    assert(shown);
+    memset(shown, 0xff, buffer_len);
+    submitted = (uint8_t *)heap_caps_malloc(buffer_len, MALLOC_CAP_INTERNAL);
+    assert(submitted);
+    memset(submitted, 0xff, buffer_len);
+
+    /* DMA 暂存区放在内部 RAM, 避免 spi_master 为 PSRAM/Flash 数据临时分配拷贝 */
+    stage_cap = buffer_len + EPD_SPI_STAGE_EXTRA;
+    stage = (uint8_t *)heap_caps_malloc(stage_cap, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    assert(stage);
+    epd_orient_init(&orient, Width, Height, EPD_ROT_0, false);
+
+    /* 异步刷新的两个窗口缓冲: 一个正在刷新, 一个接收新的请求 */
+    for (int i = 0; i < 2; i++)
+    {
+        jobs[i].data = (uint8_t *)heap_caps_malloc(buffer_len, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        assert(jobs[i].data);
+    }
+    xTaskCreatePinnedToCore(refresh_task, "epd_refresh", 4 * 1024, this, 5, &refresh_task_handle, 0);
 }
 
-epaper_driver_display::~epaper_driver_display() {
+/* 等已提交的刷新完成后让刷新任务自行退出, 再释放缓冲; 传入的 transport 由创建者释放 */
+template <typename Panel>
+epaper_driver<Panel>::~epaper_driver() {
+    EPD_RefreshWait();
+    xSemaphoreTake(refresh_done_sem, 0);
+    stopping = true;
+    xTaskNotifyGive(refresh_task_handle);
+    xSemaphoreTake(refresh_done_sem, portMAX_DELAY);
 
+    for (int i = 0; i < 2; i++)
+    {
+        heap_caps_free(jobs[i].data);
+    }
+    heap_caps_free(buffer);
+    heap_caps_free(shown);
+    heap_caps_free(submitted);
+    heap_caps_free(stage);
+    heap_caps_free(lbuf);
+    heap_caps_free(retained);
+    vSemaphoreDelete(bus_mux);
+    vSemaphoreDelete(job_mux);
+    vSemaphoreDelete(refresh_done_sem);
+    if (own_io)
+    {
+        delete io;
+    }
 }
 
-void epaper_driver_display::spi_gpio_init() {
-    int rst = lcd_spi_data.rst;
-    int cs = lcd_spi_data.cs;
-    int dc = lcd_spi_data.dc;
-    int busy = lcd_spi_data.busy;
+template <typename Panel>
+void epaper_driver<Panel>::read_busy() {
+    spi_flush_pending();
+    io->wait_busy();
+}
 
-    gpio_config_t gpio_conf = {};
-	gpio_conf.intr_type = GPIO_INTR_DISABLE;
-	gpio_conf.mode = GPIO_MODE_OUTPUT;
-	gpio_conf.pin_bit_mask = (0x1ULL<<rst) | (0x1ULL<<dc) | (0x1ULL<<cs);
-	gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
-	gpio_conf.pull_up_en = GPIO_PULLUP_ENABLE;
-	ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_config(&gpio_conf));
+template <typename Panel>
+void epaper_driver<Panel>::spi_queue(uint8_t dc_level, const uint8_t *data, int len) {
+    io->queue(dc_level, data, len);
+}
 
-	gpio_conf.mode = GPIO_MODE_INPUT;
-	gpio_conf.pin_bit_mask = (0x1ULL<<busy);
-	ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_config(&gpio_conf));
+/* 连续的 EPD_SendData 先攒在 pending 里, 凑满 4 字节或遇到下一条命令时作为一个传输发出 */
+template <typename Panel>
+void epaper_driver<Panel>::spi_flush_pending() {
+    if (pending_len)
+    {
+        spi_queue(1, pending, pending_len);
+        pending_len = 0;
+    }
+}
 
-    set_rst_1();
+/* 从 DMA 暂存区分配一段空间; 空间不够时等待队列清空后从头复用 */
+template <typename Panel>
+uint8_t *epaper_driver<Panel>::stage_alloc(int len) {
+    len = (len + 3) & ~3;
+    assert(len <= stage_cap);
+    if (stage_used + len > stage_cap)
+    {
+        EPD_SpiWait(EPD_SpiFence(NULL, NULL));
+        stage_used = 0;
+    }
+    uint8_t *p = stage + stage_used;
+    stage_used += len;
+    return p;
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SendData(uint8_t data) {
+    pending[pending_len++] = data;
+    if (pending_len == sizeof(pending))
+    {
+        spi_flush_pending();
+    }
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SendCommand(uint8_t command) {
+    spi_flush_pending();
+    spi_queue(0, &command, 1);
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::writeBytes(const uint8_t *buffer, int len) {
+    spi_flush_pending();
+    if (len <= 4)
+    {
+        spi_queue(1, buffer, len);
+        return;
+    }
+    uint8_t *dst = stage_alloc(len);
+    memcpy(dst, buffer, len);
+    spi_queue(1, dst, len);
+}
+
+/*
+ * 返回一个代表"目前为止已排队的所有传输"的票据, 可用 EPD_SpiWait 等待.
+ * cb 不为空时在这些传输完成后调用, 板上为 SPI 中断上下文 (post_cb).
+ */
+template <typename Panel>
+uint32_t epaper_driver<Panel>::EPD_SpiFence(epd_spi_done_cb_t cb, void *arg) {
+    spi_flush_pending();
+    return io->fence(cb, arg);
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SpiWait(uint32_t ticket) {
+    io->wait(ticket);
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_GetSpiStats(epd_spi_stats_t *stats) {
+    io->get_stats(stats);
 }
 
-void epaper_driver_display::spi_port_init() {
-    int mosi = lcd_spi_data.mosi;
-    int scl = lcd_spi_data.scl;
-    int spi_host = lcd_spi_data.spi_host;
-    esp_err_t ret;
-  	spi_bus_config_t buscfg = {};
-  	  	buscfg.miso_io_num = -1;
-  	  	buscfg.mosi_io_num = mosi;
-  	  	buscfg.sclk_io_num = scl;
-  	  	buscfg.quadwp_io_num = -1;
-  	  	buscfg.quadhd_io_num = -1;
-  	  	buscfg.max_transfer_sz = Width * Height;
-
-  	spi_device_interface_config_t devcfg = {};
-  	  	devcfg.spics_io_num = -1;
-  	  	devcfg.clock_speed_hz = 40 * 1000 * 1000;  //Clock out at 10 MHz
-  	  	devcfg.mode = 0;                           //SPI mode 0
-  	  	devcfg.queue_size = 7;                     //We want to be able to queue 7 transactions at a time
-
-  	ret = spi_bus_initialize((spi_host_device_t)spi_host, &buscfg, SPI_DMA_CH_AUTO);
-  	ESP_ERROR_CHECK(ret);
-  	ret = spi_bus_add_device((spi_host_device_t)spi_host, &devcfg, &spi);
-  	ESP_ERROR_CHECK(ret);
-}
-
-void epaper_driver_display::read_busy() {
-    int busy = lcd_spi_data.busy;
-    while(gpio_get_level((gpio_num_t)busy) == 1) 
-	{
-        vTaskDelay(pdMS_TO_TICKS(5));   //LOW: idle, HIGH: busy
-    }
-}
-
-void epaper_driver_display::SPI_SendByte(uint8_t data) {
-    esp_err_t ret;
-  	spi_transaction_t t; 
-  	memset(&t, 0, sizeof(t));
-  	t.length = 8;      
-  	t.tx_buffer = &data;
-  	ret = spi_device_polling_transmit(spi, &t); //Transmit!
-  	assert(ret == ESP_OK);                      //Should have had no issues.
-}
-
-void epaper_driver_display::EPD_SendData(uint8_t data) {
-    set_dc_1();
-  	set_cs_0();
-  	SPI_SendByte(data);
-  	set_cs_1();
-}
-
-void epaper_driver_display::EPD_SendCommand(uint8_t command) {
-    set_dc_0();
-  	set_cs_0();
-  	SPI_SendByte(command);
-  	set_cs_1();
-}
-
-void epaper_driver_display::writeBytes(uint8_t *buffer,int len) {
-    set_dc_1();
-  	set_cs_0();
-  	esp_err_t ret;
-  	spi_transaction_t t; 
-  	memset(&t, 0, sizeof(t));
-  	t.length = 8 * len;      
-  	t.tx_buffer = buffer;
-  	ret = spi_device_polling_transmit(spi, &t); //Transmit!
-  	assert(ret == ESP_OK);
-  	set_cs_1();
-}
-
-void epaper_driver_display::writeBytes(const uint8_t *buffer, int len) {
-    set_dc_1();
-  	set_cs_0();
-  	esp_err_t ret;
-  	spi_transaction_t t; 
-  	memset(&t, 0, sizeof(t));
-  	t.length = 8 * len;      
-  	t.tx_buffer = buffer;
-  	ret = spi_device_polling_transmit(spi, &t); //Transmit!
-  	assert(ret == ESP_OK);
-  	set_cs_1();
-}
-
-void epaper_driver_display::EPD_SetWindows(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend)
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetWindows(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend)
 {
     EPD_SendCommand(0x44);  // SET_RAM_X_ADDRESS_START_END_POSITION
     EPD_SendData((Xstart>>3) & 0xFF);
@@ -189,7 +182,8 @@ void epaper_driver_display::EPD_SetWindows(uint16_t Xstart, uint16_t Ystart, uin
     EPD_SendData((Yend >> 8) & 0xFF);
 }
 
-void epaper_driver_display::EPD_SetCursor(uint16_t Xstart, uint16_t Ystart)
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetCursor(uint16_t Xstart, uint16_t Ystart)
 {
     EPD_SendCommand(0x4E); // SET_RAM_X_ADDRESS_COUNTER
     EPD_SendData(Xstart & 0xFF);
@@ -199,7 +193,8 @@ void epaper_driver_display::EPD_SetCursor(uint16_t Xstart, uint16_t Ystart)
     EPD_SendData((Ystart >> 8) & 0xFF);
 }
 
-void epaper_driver_display::EPD_SetLut(const uint8_t *lut) {
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetLut(const uint8_t *lut) {
 	EPD_SendCommand(0x32);
     writeBytes(lut,153);
 	read_busy();
@@ -219,92 +214,247 @@ void epaper_driver_display::EPD_SetLut(const uint8_t *lut) {
     EPD_SendData(lut[158]);
 }
 
-void epaper_driver_display::EPD_TurnOnDisplay() {
-    EPD_SendCommand(0x22);
-    EPD_SendData(0xc7);
-	EPD_SendCommand(0x20);
-    read_busy();
+/* 控制器中已经是该波形时跳过上传 (153+6 字节加一次 BUSY 等待) */
+template <typename Panel>
+void epaper_driver<Panel>::load_waveform(epd_waveform_id_t id) {
+    const int band = epd_waveform_get(id)->partial ? temp_band : 0;
+    if (wf_loaded == id && wf_band == band)
+    {
+        wf_stats[id].uploads_skipped++;
+        return;
+    }
+    epd_waveform_build(id, band, lut_buf);
+    EPD_SetLut(lut_buf);
+    wf_loaded = id;
+    wf_band = band;
+    wf_stats[id].uploads++;
+}
+
+/*
+ * 用控制器内部传感器测一次温度并读回 (0x1B, 1/16 °C). 调用者需持有 bus_mux 且控制器处于 ACTIVE.
+ */
+template <typename Panel>
+bool epaper_driver<Panel>::read_temperature(int16_t *temp_x16) {
+    EPD_SendCommand(0x18);  //内部温度传感器
+    EPD_SendData(Panel::temp_sensor);
+    EPD_SendCommand(0x22);  //只测温, 不从 OTP 加载 LUT, 不影响已上传的波形
+    EPD_SendData(0xA1);
+    EPD_SendCommand(0x20);
+    read_busy();            //同时保证队列已清空
+
+    uint8_t rx[2];
+    if (!io->read(0x1B, rx, sizeof(rx)))
+    {
+        return false;
+    }
+    /* 12 位补码, 高 8 位在第一个字节 */
+    *temp_x16 = (int16_t)((rx[0] << 8) | rx[1]) >> 4;
+    return *temp_x16 > EPD_TEMP_MIN_X16 && *temp_x16 < EPD_TEMP_MAX_X16;
+}
+
+/* 到了测温周期就读一次温度并更新档位; 档位变化后影子记录失效, 下一次 load_waveform 会重新上传 */
+template <typename Panel>
+void epaper_driver<Panel>::update_temperature() {
+    const int64_t now = esp_timer_get_time();
+    if (temp.reads + temp.read_errors && now - temp_read_us < (int64_t)EPD_TEMP_PERIOD_MS * 1000)
+    {
+        return;
+    }
+    temp_read_us = now;
+    int16_t t;
+    if (!read_temperature(&t))
+    {
+        temp.read_errors++;
+        ESP_LOGW(TAG, "Temperature read failed, using worst-case waveform");
+        temp_band = 0;
+        temp.band = 0;
+        return;
+    }
+    temp.reads++;
+    temp.valid = true;
+    temp.temp_x16 = t;
+    int band = epd_waveform_temp_band(t, temp_band);
+    if (band != temp_band)
+    {
+        ESP_LOGI(TAG, "Panel %d.%d C, waveform band %d -> %d", t / 16, (abs(t) % 16) * 10 / 16, temp_band, band);
+        temp_band = band;
+    }
+    temp.band = band;
 }
 
-void epaper_driver_display::EPD_TurnOnDisplayPart() {
+/* 发出 0x22/0x20 并等待波形结束, 耗时记在当前加载的波形上 */
+template <typename Panel>
+void epaper_driver<Panel>::timed_update(uint8_t ctrl) {
     EPD_SendCommand(0x22);
-    EPD_SendData(0xcf);
+    EPD_SendData(ctrl);
     EPD_SendCommand(0x20);
+    EPD_SpiWait(EPD_SpiFence(NULL, NULL));
+    const int64_t t0 = esp_timer_get_time();
     read_busy();
+    if (wf_loaded == EPD_WF_NONE)
+    {
+        return;
+    }
+    const uint32_t us = esp_timer_get_time() - t0;
+    epd_waveform_stats_t *st = &wf_stats[wf_loaded];
+    st->runs++;
+    st->last_us = us;
+    st->total_us += us;
+    if (st->min_us == 0 || us < st->min_us)
+    {
+        st->min_us = us;
+    }
+    if (us > st->max_us)
+    {
+        st->max_us = us;
+    }
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_TurnOnDisplay() {
+    timed_update(epd_waveform_get(EPD_WF_FULL)->update_ctrl);
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_TurnOnDisplayPart() {
+    const epd_waveform_t *wf = epd_waveform_get(wf_loaded);
+    timed_update(wf ? wf->update_ctrl : 0xcf);
 }
 
-void epaper_driver_display::EPD_Init() {
+template <typename Panel>
+void epaper_driver<Panel>::EPD_Init() {
+    xSemaphoreTakeRecursive(bus_mux, portMAX_DELAY);
+    if (power_state == EPD_POWER_OFF && power_hook)
+    {
+        power_hook(true, power_hook_arg);
+        io->delay_ms(EPD_RAIL_SETTLE_MS);
+    }
     set_rst_1();
-  	vTaskDelay(pdMS_TO_TICKS(50));
+  	io->delay_ms(50);
   	set_rst_0();
-  	vTaskDelay(pdMS_TO_TICKS(20));
+  	io->delay_ms(20);
   	set_rst_1();
-  	vTaskDelay(pdMS_TO_TICKS(50));
+  	io->delay_ms(50);
+    wf_loaded = EPD_WF_NONE;
 
     read_busy();
     EPD_SendCommand(0x12);  //SWRESET
     read_busy();
 
     EPD_SendCommand(0x01); //Driver output control
-    EPD_SendData(0xC7);
-    EPD_SendData(0x00);
-    EPD_SendData(0x01);
+    EPD_SendData((Panel::gate_lines - 1) & 0xFF);
+    EPD_SendData((Panel::gate_lines - 1) >> 8);
+    EPD_SendData(Panel::scan_ctrl);
 
     EPD_SendCommand(0x11); //data entry mode
-    EPD_SendData(0x01);
+    EPD_SendData(Panel::entry_mode);
 
-	EPD_SetWindows(0, Width-1, Height-1, 0);
+	EPD_SetWindows(0, Height-1, Width-1, 0);
 
     EPD_SendCommand(0x3C); //BorderWavefrom
-    EPD_SendData(0x01);
+    EPD_SendData(Panel::border_full);
 
     EPD_SendCommand(0x18);
-    EPD_SendData(0x80);
+    EPD_SendData(Panel::temp_sensor);
 
     EPD_SendCommand(0x22); //Load Temperature and waveform setting.
     EPD_SendData(0XB1);
     EPD_SendCommand(0x20);
+	read_busy();            //BUSY 期间控制器不接受命令, 等测温和载入结束再设光标
 
     EPD_SetCursor(0, Height-1);
-	read_busy();
 	
-	EPD_SetLut(WF_Full_1IN54);
+	load_waveform(EPD_WF_FULL);
+    set_power_state(EPD_POWER_ACTIVE);
+    xSemaphoreGiveRecursive(bus_mux);
 }
 
-void epaper_driver_display::EPD_Clear() {
-    int buffer_len = lcd_spi_data.buffer_len;
+template <typename Panel>
+void epaper_driver<Panel>::EPD_Clear() {
     memset(buffer,0xff,buffer_len);
+    if (lbuf)
+    {
+        memset(lbuf, 0xff, orient.lstride * orient.lh);
+    }
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetFullWindow() {
+    EPD_SetWindows(0, Height-1, Width-1, 0);
+    EPD_SetCursor(0, Height-1);
 }
 
-void epaper_driver_display::EPD_Display() {
-    int buffer_len = lcd_spi_data.buffer_len;
+template <typename Panel>
+void epaper_driver<Panel>::EPD_Display() {
+    xSemaphoreTakeRecursive(bus_mux, portMAX_DELAY);
+    if (power_state != EPD_POWER_ACTIVE)
+    {
+        EPD_Init();
+    }
+    EPD_SetFullWindow();
     EPD_SendCommand(0x24);
     assert(buffer);
     writeBytes(buffer,buffer_len);
     EPD_TurnOnDisplay();
+    xSemaphoreTake(job_mux, portMAX_DELAY);
+    memcpy(shown, buffer, buffer_len);
+    memcpy(submitted, buffer, buffer_len);
+    frame_dirty = true;
+    xSemaphoreGive(job_mux);
+    EPD_SetFullWindow();
+    EPD_SendCommand(0x26);      //全刷后同步旧图 RAM, 后续局部刷新以屏幕当前内容为参考
+    writeBytes(buffer,buffer_len);
+    xSemaphoreGiveRecursive(bus_mux);
 }
 
-void epaper_driver_display::EPD_DisplayPartBaseImage() {
-    int buffer_len = lcd_spi_data.buffer_len;
+template <typename Panel>
+void epaper_driver<Panel>::EPD_DisplayPartBaseImage() {
+    xSemaphoreTakeRecursive(bus_mux, portMAX_DELAY);
+    if (power_state != EPD_POWER_ACTIVE)
+    {
+        EPD_Init();
+    }
+    EPD_SetFullWindow();
     EPD_SendCommand(0x24);
     assert(buffer);
     writeBytes(buffer,buffer_len);
     EPD_SendCommand(0x26);
     writeBytes(buffer,buffer_len);
     EPD_TurnOnDisplay();
+    xSemaphoreTake(job_mux, portMAX_DELAY);
+    memcpy(shown, buffer, buffer_len);
+    memcpy(submitted, buffer, buffer_len);
+    frame_dirty = true;
+    xSemaphoreGive(job_mux);
+    xSemaphoreGiveRecursive(bus_mux);
 }
 
-void epaper_driver_display::EPD_Init_Partial() {
-    set_rst_1();
-  	vTaskDelay(pdMS_TO_TICKS(50));
-  	set_rst_0();
-  	vTaskDelay(pdMS_TO_TICKS(20));
-  	set_rst_1();
-  	vTaskDelay(pdMS_TO_TICKS(50));
+template <typename Panel>
+void epaper_driver<Panel>::EPD_Init_Partial() {
+    xSemaphoreTakeRecursive(bus_mux, portMAX_DELAY);
+    enter_partial(EPD_WF_PARTIAL);
+    xSemaphoreGiveRecursive(bus_mux);
+}
 
-	read_busy();
-	
-	EPD_SetLut(WF_PARTIAL_1IN54_0);
+/*
+ * 切换到局部刷新模式并加载 id 对应的局部波形, 调用者需持有 bus_mux.
+ * 控制器处于 ACTIVE 时状态已知, 不再硬件复位; 已在局部模式时最多换一次 LUT;
+ * 深睡或断电时走 power_up 的唤醒流程.
+ */
+template <typename Panel>
+void epaper_driver<Panel>::enter_partial(epd_waveform_id_t id) {
+    if (power_state != EPD_POWER_ACTIVE)
+    {
+        power_up(id);
+        return;
+    }
+    update_temperature();
+    const epd_waveform_t *cur = epd_waveform_get(wf_loaded);
+    load_waveform(id);
+    if (cur && cur->partial)
+    {
+        return;
+    }
 
     EPD_SendCommand(0x37); 
     EPD_SendData(0x00);  
@@ -319,7 +469,7 @@ void epaper_driver_display::EPD_Init_Partial() {
     EPD_SendData(0x00);
 	
     EPD_SendCommand(0x3C); //BorderWavefrom
-    EPD_SendData(0x80);
+    EPD_SendData(Panel::border_partial);
 	
 	EPD_SendCommand(0x22); 
 	EPD_SendData(0xc0); 
@@ -327,22 +477,683 @@ void epaper_driver_display::EPD_Init_Partial() {
 	read_busy();
 }
 
-void epaper_driver_display::EPD_DisplayPart() {
-    EPD_SendCommand(0x24);
-    assert(buffer);
-    writeBytes(buffer,5000);
+template <typename Panel>
+void epaper_driver<Panel>::EPD_DisplayPart() {
+    EPD_DisplayPartWindow(0, 0, orient.lw-1, orient.lh-1);
+}
+
+/* 把逻辑窗口映射到面板坐标, 再把 X 方向扩展到字节边界; 窗口非法时返回 false */
+template <typename Panel>
+bool epaper_driver<Panel>::align_window(epd_window_t *win, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+    if (x1 > x2 || y1 > y2 || x2 >= orient.lw || y2 >= orient.lh)
+    {
+        ESP_LOGE(TAG, "Invalid window: (%d,%d)-(%d,%d)", x1, y1, x2, y2);
+        return false;
+    }
+    const epd_window_t logical = {x1, y1, x2, y2};
+    epd_orient_map_window(&orient, &logical, win);
+    win->x1 &= ~0x07;
+    win->x2 |= 0x07;
+    return true;
+}
+
+/* 把 buffer 中窗口覆盖的各行连续拷贝到 dst, 返回字节数 */
+template <typename Panel>
+int epaper_driver<Panel>::gather_window(const epd_window_t *win, uint8_t *dst) {
+    const int stride = Stride;
+    const int row_bytes = (win->x2 - win->x1 + 1) >> 3;
+    const int rows = win->y2 - win->y1 + 1;
+    if (row_bytes == stride)
+    {
+        memcpy(dst, buffer + win->y1 * stride, row_bytes * rows);   //整行连续, 一次拷完
+    }
+    else
+    {
+        for (int y = win->y1; y <= win->y2; y++)
+        {
+            memcpy(dst + (y - win->y1) * row_bytes, buffer + y * stride + (win->x1 >> 3), row_bytes);
+        }
+    }
+    return row_bytes * rows;
+}
+
+/* 依次收集 diff 中各窗口的内容, 返回总字节数 */
+template <typename Panel>
+int epaper_driver<Panel>::gather_diff(const epd_diff_t *diff, uint8_t *dst) {
+    int len = 0;
+    for (int i = 0; i < diff->count; i++)
+    {
+        len += gather_window(&diff->bands[i], dst + len);
+    }
+    return len;
+}
+
+/* gather_diff 的逆过程: 把按行收集好的窗口内容写回整帧 dst */
+template <typename Panel>
+void epaper_driver<Panel>::scatter_diff(uint8_t *dst, const epd_diff_t *diff, const uint8_t *data) {
+    const int stride = Stride;
+    for (int i = 0; i < diff->count; i++)
+    {
+        const epd_window_t *win = &diff->bands[i];
+        const int row_bytes = (win->x2 - win->x1 + 1) >> 3;
+        for (int y = win->y1; y <= win->y2; y++, data += row_bytes)
+        {
+            memcpy(dst + y * stride + (win->x1 >> 3), data, row_bytes);
+        }
+    }
+}
+
+/*
+ * 把已按行收集好的窗口数据写入控制器 RAM (0x24 新图 / 0x26 旧图). data 必须在内部 DMA 内存中, 且在传输完成前保持有效.
+ * 地址映射与 EPD_Init 一致: X 以字节递增, buffer 第 y 行对应 RAM Y 地址 Height-1-y.
+ */
+template <typename Panel>
+void epaper_driver<Panel>::write_window_ram(uint8_t ram, const epd_window_t *win, const uint8_t *data, int len) {
+    EPD_SetWindows(win->x1, Height-1-win->y1, win->x2, Height-1-win->y2);
+    EPD_SetCursor(win->x1 >> 3, Height-1-win->y1);
+    EPD_SendCommand(ram);
+    spi_flush_pending();
+    spi_queue(1, data, len);
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::write_diff_ram(uint8_t ram, const epd_diff_t *diff, const uint8_t *data) {
+    for (int i = 0; i < diff->count; i++)
+    {
+        const epd_window_t *win = &diff->bands[i];
+        int len = ((win->x2 - win->x1 + 1) >> 3) * (win->y2 - win->y1 + 1);
+        write_window_ram(ram, win, data, len);
+        data += len;
+    }
+}
+
+/*
+ * 局部刷新: 新内容写入 0x24, 波形按 0x26(旧) -> 0x24(新) 只驱动变化的像素.
+ * 刷新完成后把同样的窗口写入 0x26, 使旧图 RAM 始终等于屏幕当前内容, 下一次局部刷新以它为参考.
+ */
+template <typename Panel>
+void epaper_driver<Panel>::refresh_diff(const epd_diff_t *diff, const uint8_t *data, epd_waveform_id_t wf) {
+    enter_partial(wf);
+    write_diff_ram(0x24, diff, data);
     EPD_TurnOnDisplayPart();
+    mark_pixels_done();
+    write_diff_ram(0x26, diff, data);
+    EPD_SpiWait(EPD_SpiFence(NULL, NULL));
+    xSemaphoreTake(job_mux, portMAX_DELAY);
+    refresh_stats.issued++;
+    xSemaphoreGive(job_mux);
+}
+
+/*
+ * 只把 (x1,y1)-(x2,y2) 内真正变化的行段写入控制器, 再做一次局部刷新 (阻塞到刷新完成).
+ * 与已显示内容完全相同时直接返回. 行段与异步刷新一样收集到 jobs[].data 后由 epd_refresh 任务立即发出,
+ * 不放在 DMA 暂存区: 随后的 EPD_Init/唤醒会从暂存区分配整帧, 回绕时会覆盖尚未写入的行段.
+ */
+template <typename Panel>
+void epaper_driver<Panel>::EPD_DisplayPartWindow(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+    EPD_RefreshAsync(x1, y1, x2, y2, NULL, NULL, EPD_UPDATE_NORMAL, 0);
+    EPD_RefreshWait();
+}
+
+/*
+ * 非阻塞局部刷新: 与已提交内容做差分, 把变化的行段从 buffer 拷贝出来后立即返回, 调用者随后可以继续修改 buffer.
+ * RAM 写入和刷新波形由 epd_refresh 任务完成, 波形结束后才更新 shown, 再在该任务中调用 cb.
+ * 上一次刷新还在进行时, 新的变化与尚未开始的请求合并, 排在其后. 内容没有变化的请求不刷新,
+ * 但 cb 仍排在已提交的刷新之后调用, 调用者看到的完成顺序与提交顺序一致; 没有待处理的刷新时立即调用.
+ */
+template <typename Panel>
+void epaper_driver<Panel>::EPD_RefreshAsync(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, epd_refresh_cb_t cb, void *arg,
+                                             epd_update_class_t cls, uint32_t max_delay_ms) {
+    epd_window_t win;
+    if (!align_window(&win, x1, y1, x2, y2))
+    {
+        return;
+    }
+    assert(buffer);
+
+    xSemaphoreTake(job_mux, portMAX_DELAY);
+    epd_refresh_job_t *job = &jobs[job_pending];
+    const bool in_flight = jobs[job_pending ^ 1].valid;
+    const int64_t now = esp_timer_get_time();
+    epd_diff_t diff;
+    bool changed = epd_frame_diff(submitted, buffer, Width, Height, &win, &diff);
+    if (!changed)
+    {
+        refresh_stats.skipped++;
+        if (!job->valid && !in_flight)
+        {
+            xSemaphoreGive(job_mux);
+            if (cb)
+            {
+                cb(arg);
+            }
+            return;
+        }
+        if (!job->valid)
+        {
+            /* 只带回调的空请求, 刷新任务在进行中的刷新完成后直接调用回调 */
+            job->diff.count = 0;
+            job->changed_px = 0;
+            job->len = 0;
+            job->cls = cls;
+            job->window_us = now;
+            job->issue_us = now;
+        }
+    }
+    else
+    {
+        const int64_t deadline = (max_delay_ms == EPD_LATENCY_ANY) ? INT64_MAX : now + (int64_t)max_delay_ms * 1000;
+        refresh_stats.requests++;
+        if (!job->valid || job->diff.count == 0)
+        {
+            job->diff.count = 0;
+            job->changed_px = 0;
+            job->cls = cls;
+            job->window_us = now + (int64_t)coalesce_ms * 1000;
+            job->issue_us = job->window_us;
+        }
+        else
+        {
+            refresh_stats.merged++;
+            if (cls < job->cls)
+            {
+                job->cls = cls;     //合并后按最紧急的请求处理
+            }
+        }
+        if (deadline < job->issue_us)
+        {
+            job->issue_us = deadline;
+        }
+        for (int i = 0; i < diff.count; i++)
+        {
+            epd_diff_add_band(&job->diff, &diff.bands[i]);
+        }
+        job->changed_px += diff.changed_px;
+        job->len = gather_diff(&job->diff, job->data);   //合并后的窗口整体重新收集, 取 buffer 中最新内容
+        scatter_diff(submitted, &job->diff, job->data);
+    }
+    if (cb)
+    {
+        if (job->cb_count < EPD_REFRESH_MAX_CB)
+        {
+            job->cbs[job->cb_count] = cb;
+            job->args[job->cb_count] = arg;
+            job->cb_count++;
+        }
+        else
+        {
+            ESP_LOGW(TAG, "Refresh callback dropped");
+        }
+    }
+    job->valid = true;
+    xSemaphoreGive(job_mux);
+
+    xTaskNotifyGive(refresh_task_handle);
+}
+
+/* 等待所有已提交的异步刷新完成 */
+template <typename Panel>
+void epaper_driver<Panel>::EPD_RefreshWait() {
+    for (;;)
+    {
+        xSemaphoreTake(job_mux, portMAX_DELAY);
+        bool idle = !jobs[0].valid && !jobs[1].valid;
+        xSemaphoreGive(job_mux);
+        if (idle)
+        {
+            return;
+        }
+        xSemaphoreTake(refresh_done_sem, pdMS_TO_TICKS(EPD_REFRESH_WAIT_MS));
+    }
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_GetRefreshStats(epd_refresh_stats_t *stats) {
+    xSemaphoreTake(job_mux, portMAX_DELAY);     //计数都在 job_mux 下更新, 拷贝时也持有
+    *stats = refresh_stats;
+    xSemaphoreGive(job_mux);
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetCoalesceWindow(uint32_t ms) {
+    coalesce_ms = ms;
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetScheduler(epaper_refresh_scheduler *sched) {
+    scheduler = sched;
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetFrameStore(epaper_frame_store *store) {
+    frame_store = store;
 }
 
-void epaper_driver_display::EPD_DrawColorPixel(uint16_t x, uint16_t y,uint8_t color) {
-    if (x >= Width || y >= Height)
+/*
+ * 把 shown 存到 flash, 只在没有待处理刷新时调用, 调用者需持有 bus_mux.
+ * 先拷到内部 RAM 再写, 写 flash 期间不占用 job_mux.
+ */
+template <typename Panel>
+void epaper_driver<Panel>::persist_frame(bool force) {
+    if (frame_store == NULL || !frame_dirty)
+    {
+        return;
+    }
+    uint8_t *dst = stage_alloc(buffer_len);
+    xSemaphoreTake(job_mux, portMAX_DELAY);
+    memcpy(dst, shown, buffer_len);
+    frame_dirty = false;
+    xSemaphoreGive(job_mux);
+    if (!frame_store->save(dst, force))
+    {
+        frame_dirty = true;     //被限速或写失败, 下次空闲再试
+    }
+}
+
+/*
+ * 电子纸断电后画面不变, 开机时把上次保存的帧当作屏幕当前内容: 初始化控制器, 两块 RAM 都写入该帧,
+ * 进入局部刷新模式. 之后的第一次更新就是普通的局部刷新, 不需要全刷清屏.
+ */
+template <typename Panel>
+bool epaper_driver<Panel>::EPD_RestoreFrame() {
+    if (frame_store == NULL)
+    {
+        return false;
+    }
+    xSemaphoreTakeRecursive(bus_mux, portMAX_DELAY);
+    uint8_t *dst = stage_alloc(buffer_len);
+    if (!frame_store->load(dst))
+    {
+        xSemaphoreGiveRecursive(bus_mux);
+        return false;
+    }
+    xSemaphoreTake(job_mux, portMAX_DELAY);
+    memcpy(shown, dst, buffer_len);
+    memcpy(submitted, dst, buffer_len);
+    memcpy(buffer, dst, buffer_len);
+    xSemaphoreGive(job_mux);
+    EPD_Init();
+    restore_ram();
+    enter_partial(EPD_WF_PARTIAL);
+    xSemaphoreGiveRecursive(bus_mux);
+    return true;
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_GetTemperature(epd_temperature_t *out) {
+    *out = temp;
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_GetWaveformStats(epd_waveform_id_t id, epd_waveform_stats_t *stats) {
+    if (id < 0 || id >= EPD_WF_COUNT)
+    {
+        return;
+    }
+    *stats = wf_stats[id];
+}
+
+/*
+ * 用全刷波形重画 shown (屏幕上的整帧) 并叠加 diff 中按行收集好的 data (可为空), 两个 RAM 同时更新,
+ * 波形结束后更新 shown, 之后恢复局部刷新模式. 调用者需持有 bus_mux.
+ */
+template <typename Panel>
+void epaper_driver<Panel>::refresh_full_frame(const epd_diff_t *diff, const uint8_t *data) {
+    const epd_power_state_t from = power_state;
+    const int64_t t0 = esp_timer_get_time();
+    EPD_Init();     //硬件复位兼作唤醒, RAM 随后整帧重写
+    if (from != EPD_POWER_ACTIVE)
+    {
+        count_wake(from, t0);
+    }
+    uint8_t *dst = stage_alloc(buffer_len);
+    xSemaphoreTake(job_mux, portMAX_DELAY);
+    memcpy(dst, shown, buffer_len);
+    xSemaphoreGive(job_mux);
+    if (diff)
+    {
+        scatter_diff(dst, diff, data);
+    }
+
+    EPD_SetFullWindow();
+    EPD_SendCommand(0x24);
+    spi_flush_pending();
+    spi_queue(1, dst, buffer_len);
+    EPD_TurnOnDisplay();
+    mark_pixels_done();
+    xSemaphoreTake(job_mux, portMAX_DELAY);
+    memcpy(shown, dst, buffer_len);
+    frame_dirty = true;
+    xSemaphoreGive(job_mux);
+    EPD_SetFullWindow();
+    EPD_SendCommand(0x26);
+    spi_flush_pending();
+    spi_queue(1, dst, buffer_len);
+    EPD_Init_Partial();
+
+    xSemaphoreTake(job_mux, portMAX_DELAY);
+    refresh_stats.issued++;
+    xSemaphoreGive(job_mux);
+    if (scheduler)
+    {
+        scheduler->on_full();
+    }
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_FullRefresh() {
+    EPD_RefreshWait();
+    xSemaphoreTakeRecursive(bus_mux, portMAX_DELAY);
+    refresh_full_frame();
+    xSemaphoreGiveRecursive(bus_mux);
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::refresh_task(void *arg) {
+    epaper_driver *self = (epaper_driver *)arg;
+    for (;;)
+    {
+        if (self->stopping)
+        {
+            xSemaphoreGive(self->refresh_done_sem);
+            vTaskDelete(NULL);
+        }
+        const bool sleep_pending = self->auto_sleep_ms && self->power_state == EPD_POWER_ACTIVE;
+        const uint32_t wait_ms = sleep_pending ? self->auto_sleep_ms : EPD_IDLE_CHECK_MS;
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait_ms)) == 0)
+        {
+            xSemaphoreTakeRecursive(self->bus_mux, portMAX_DELAY);
+            /* 长时间没有刷新请求, 在安静时段主动做一次清洁全刷 */
+            if (self->scheduler && self->scheduler->idle_full_due())
+            {
+                self->refresh_full_frame();
+            }
+            xSemaphoreTake(self->job_mux, portMAX_DELAY);
+            bool idle = !self->jobs[0].valid && !self->jobs[1].valid;
+            xSemaphoreGive(self->job_mux);
+            if (idle)
+            {
+                self->persist_frame(false);
+                if (self->auto_sleep_ms)
+                {
+                    self->power_down(self->auto_sleep_rail_off);
+                }
+            }
+            xSemaphoreGiveRecursive(self->bus_mux);
+            continue;
+        }
+
+        /* 合并窗口: 等到窗口结束或最早的截止时间, 期间到达的请求并入同一个 job, 也可能把截止时间提前 */
+        epd_refresh_job_t *job;
+        for (;;)
+        {
+            xSemaphoreTake(self->job_mux, portMAX_DELAY);
+            job = &self->jobs[self->job_pending];
+            if (!job->valid)
+            {
+                xSemaphoreGive(self->job_mux);
+                job = NULL;
+                break;
+            }
+            const int64_t wait_us = job->issue_us - esp_timer_get_time();
+            if (wait_us <= 0)
+            {
+                if (job->issue_us < job->window_us)
+                {
+                    self->refresh_stats.deadline_cut++;
+                }
+                self->job_pending ^= 1;     //后续请求写入另一个缓冲
+                xSemaphoreGive(self->job_mux);
+                break;
+            }
+            xSemaphoreGive(self->job_mux);
+            TickType_t ticks = pdMS_TO_TICKS((wait_us + 999) / 1000);
+            ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+        }
+        if (job == NULL)
+        {
+            continue;
+        }
+
+        if (job->diff.count)
+        {
+            xSemaphoreTakeRecursive(self->bus_mux, portMAX_DELAY);
+            epd_waveform_id_t wf = self->scheduler ? self->scheduler->pick_waveform(job->cls, job->changed_px) : EPD_WF_PARTIAL;
+            if (wf == EPD_WF_FULL)
+            {
+                self->refresh_full_frame(&job->diff, job->data);
+            }
+            else
+            {
+                self->refresh_diff(&job->diff, job->data, wf);
+                xSemaphoreTake(self->job_mux, portMAX_DELAY);
+                self->scatter_diff(self->shown, &job->diff, job->data);     //波形已结束, 这些像素已在屏上
+                self->frame_dirty = true;
+                xSemaphoreGive(self->job_mux);
+                if (self->scheduler)
+                {
+                    self->scheduler->on_partial(job->changed_px);
+                }
+            }
+            xSemaphoreGiveRecursive(self->bus_mux);
+        }
+
+        for (int i = 0; i < job->cb_count; i++)
+        {
+            job->cbs[i](job->args[i]);
+        }
+
+        xSemaphoreTake(self->job_mux, portMAX_DELAY);
+        job->cb_count = 0;
+        job->valid = false;
+        xSemaphoreGive(self->job_mux);
+        xSemaphoreGive(self->refresh_done_sem);
+    }
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::set_power_state(epd_power_state_t state) {
+    const int64_t now = esp_timer_get_time();
+    if (power_since_us)
+    {
+        if (power_state == EPD_POWER_ACTIVE)
+        {
+            power_stats.active_us += now - power_since_us;
+        }
+        else
+        {
+            power_stats.idle_us += now - power_since_us;
+        }
+    }
+    power_since_us = now;
+    power_state = state;
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::count_wake(epd_power_state_t from, int64_t t0) {
+    if (from == EPD_POWER_SLEEP)
+    {
+        power_stats.wakes_from_sleep++;
+    }
+    else
+    {
+        power_stats.wakes_from_off++;
+    }
+    power_stats.last_wake_us = esp_timer_get_time() - t0;
+    wake_start_us = t0;
+}
+
+/* 唤醒后的第一次刷新波形结束, 记录唤醒到像素更新的延迟 */
+template <typename Panel>
+void epaper_driver<Panel>::mark_pixels_done() {
+    if (wake_start_us == 0)
+    {
+        return;
+    }
+    uint32_t us = esp_timer_get_time() - wake_start_us;
+    wake_start_us = 0;
+    power_stats.last_wake_to_pixels_us = us;
+    if (us > power_stats.max_wake_to_pixels_us)
+    {
+        power_stats.max_wake_to_pixels_us = us;
+    }
+    ESP_LOGD(TAG, "Wake to pixels: %lu us (wake %lu us)", (unsigned long)us, (unsigned long)power_stats.last_wake_us);
+}
+
+/* 断电后 RAM 丢失, 把断电前屏幕上的画面写回两块 RAM, 局部刷新才有正确的参考 */
+template <typename Panel>
+void epaper_driver<Panel>::restore_ram() {
+    uint8_t *dst = stage_alloc(buffer_len);
+    if (retained)
+    {
+        memcpy(dst, retained, buffer_len);
+    }
+    else
+    {
+        xSemaphoreTake(job_mux, portMAX_DELAY);
+        memcpy(dst, shown, buffer_len);
+        xSemaphoreGive(job_mux);
+    }
+    EPD_SetFullWindow();
+    EPD_SendCommand(0x24);
+    spi_flush_pending();
+    spi_queue(1, dst, buffer_len);
+    EPD_SetFullWindow();
+    EPD_SendCommand(0x26);
+    spi_flush_pending();
+    spi_queue(1, dst, buffer_len);
+}
+
+/*
+ * 把控制器带到可以局部刷新的状态, 调用者需持有 bus_mux.
+ * 深睡模式 1 保留 RAM, 只需硬件复位并恢复被复位清掉的寄存器和 LUT, 不做软复位也不重写 RAM;
+ * 断电过则完整初始化并恢复 RAM.
+ */
+template <typename Panel>
+void epaper_driver<Panel>::power_up(epd_waveform_id_t wf) {
+    if (power_state == EPD_POWER_ACTIVE)
+    {
+        return;
+    }
+    const epd_power_state_t from = power_state;
+    const int64_t t0 = esp_timer_get_time();
+    if (from == EPD_POWER_OFF)
+    {
+        EPD_Init();
+        restore_ram();
+    }
+    else
+    {
+        set_rst_0();
+        io->delay_ms(EPD_WAKE_RST_MS);
+        set_rst_1();
+        io->delay_ms(EPD_WAKE_RST_MS);
+        wf_loaded = EPD_WF_NONE;
+        read_busy();
+
+        EPD_SendCommand(0x01); //Driver output control
+        EPD_SendData((Panel::gate_lines - 1) & 0xFF);
+        EPD_SendData((Panel::gate_lines - 1) >> 8);
+        EPD_SendData(Panel::scan_ctrl);
+
+        EPD_SendCommand(0x11); //data entry mode
+        EPD_SendData(Panel::entry_mode);
+        set_power_state(EPD_POWER_ACTIVE);
+    }
+    enter_partial(wf);
+    count_wake(from, t0);
+}
+
+/* 进入深睡 (0x10 模式 1), rail_off 时再关闭面板供电; 调用者需持有 bus_mux 且没有进行中的刷新 */
+template <typename Panel>
+void epaper_driver<Panel>::power_down(bool rail_off) {
+    if (power_state == EPD_POWER_OFF)
+    {
+        return;
+    }
+    if (power_state == EPD_POWER_ACTIVE)
+    {
+        EPD_SendCommand(0x10);  //Deep sleep, 之后 BUSY 保持高电平直到硬件复位
+        EPD_SendData(0x01);
+        EPD_SpiWait(EPD_SpiFence(NULL, NULL));
+    }
+    wf_loaded = EPD_WF_NONE;
+    wake_start_us = 0;
+
+    if (rail_off && power_hook && !retained)
+    {
+        retained = (uint8_t *)heap_caps_malloc(buffer_len, MALLOC_CAP_SPIRAM);
+    }
+    if (rail_off && power_hook && retained)
+    {
+        xSemaphoreTake(job_mux, portMAX_DELAY);
+        memcpy(retained, shown, buffer_len);
+        xSemaphoreGive(job_mux);
+        set_rst_0();    //避免经 RST 引脚给断电的控制器倒灌供电
+        power_hook(false, power_hook_arg);
+        set_power_state(EPD_POWER_OFF);
+    }
+    else
+    {
+        set_power_state(EPD_POWER_SLEEP);
+    }
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetPowerHook(epd_power_hook_t hook, void *arg) {
+    xSemaphoreTakeRecursive(bus_mux, portMAX_DELAY);
+    power_hook = hook;
+    power_hook_arg = arg;
+    xSemaphoreGiveRecursive(bus_mux);
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetAutoSleep(uint32_t idle_ms, bool rail_off) {
+    auto_sleep_ms = idle_ms;
+    auto_sleep_rail_off = rail_off;
+    xTaskNotifyGive(refresh_task_handle);   //让刷新任务按新的超时重新等待
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_Sleep(bool rail_off) {
+    EPD_RefreshWait();
+    xSemaphoreTakeRecursive(bus_mux, portMAX_DELAY);
+    persist_frame(true);
+    power_down(rail_off);
+    xSemaphoreGiveRecursive(bus_mux);
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_GetPowerStats(epd_power_stats_t *stats) {
+    *stats = power_stats;
+    stats->state = power_state;
+    const int64_t since = power_since_us;
+    if (since)
+    {
+        const int64_t now = esp_timer_get_time();
+        if (stats->state == EPD_POWER_ACTIVE)
+        {
+            stats->active_us += now - since;
+        }
+        else
+        {
+            stats->idle_us += now - since;
+        }
+    }
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_DrawColorPixel(uint16_t x, uint16_t y,uint8_t color) {
+    if (x >= orient.lw || y >= orient.lh)
     {
         ESP_LOGE("EPD", "Out of bounds pixel: (%d,%d)", x, y);
         return; 
     }
 
-    uint16_t index = y * 25 + (x >> 3); //25是200/8
-    uint8_t bit = 7 - (x & 0x07);
+    int px, py;
+    epd_orient_map(&orient, x, y, &px, &py);
+    uint16_t index = py * Stride + (px >> 3);
+    uint8_t bit = 7 - (px & 0x07);
     if(color == DRIVER_COLOR_WHITE)
     {
         buffer[index] |= (0x01 << bit);
@@ -351,4 +1162,151 @@ void epaper_driver_display::EPD_DrawColorPixel(uint16_t x, uint16_t y,uint8_t co
     {
         buffer[index] &= ~(0x01 << bit);
     }
+    if (lbuf)   //逻辑画面保持同步
+    {
+        uint8_t *p = lbuf + y * orient.lstride + (x >> 3);
+        const uint8_t m = 0x80 >> (x & 0x07);
+        *p = (color == DRIVER_COLOR_WHITE) ? (*p | m) : (*p & ~m);
+    }
 }
+
+/*
+ * 按行整字节打包, 代替逐像素调用 EPD_DrawColorPixel; 每行按二值化区域切成若干段.
+ * 旋转/镜像时先打包进逻辑画面, 再按 8x8 块转写到面板帧缓冲.
+ */
+template <typename Panel>
+void epaper_driver<Panel>::EPD_DrawRGB565Area(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const uint16_t *src) {
+    if (x2 >= orient.lw || y2 >= orient.lh || x1 > x2 || y1 > y2 || (x1 & 0x07))
+    {
+        ESP_LOGE("EPD", "Bad pack area: (%d,%d)-(%d,%d)", x1, y1, x2, y2);
+        return;
+    }
+    const int stride = orient.lstride;
+    uint8_t *fb = draw_buffer();
+    if (pack_region_count == 0)
+    {
+        epd_pack_rgb565_rect(src, fb, stride, x1, y1, x2, y2, pack_mode);
+        EPD_CommitArea(x1, y1, x2, y2);
+        return;
+    }
+
+    const int w = x2 - x1 + 1;
+    for (int y = y1; y <= y2; y++, src += w)
+    {
+        uint8_t *row = fb + y * stride;
+        int x = x1;
+        while (x <= x2)
+        {
+            uint16_t end;
+            const epd_pack_mode_t mode = EPD_GetPackMode(x, y, &end);
+            if (end > x2)
+            {
+                end = x2;
+            }
+            epd_pack_rgb565_row(src + (x - x1), row + (x >> 3), end - x + 1, y, mode);
+            x = end + 1;
+        }
+    }
+    EPD_CommitArea(x1, y1, x2, y2);
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetPackMode(epd_pack_mode_t mode) {
+    pack_mode = mode;
+}
+
+/* 区域在 X 方向向外扩到字节边界, 保证每段都从整字节开始 */
+template <typename Panel>
+bool epaper_driver<Panel>::EPD_AddPackRegion(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, epd_pack_mode_t mode) {
+    if (pack_region_count >= EPD_PACK_MAX_REGIONS || x1 > x2 || y1 > y2)
+    {
+        return false;
+    }
+    epd_pack_region_t *r = &pack_regions[pack_region_count];
+    r->win.x1 = x1 & ~0x07;
+    r->win.x2 = ((x2 | 0x07) < orient.lw) ? (x2 | 0x07) : (orient.lw - 1);
+    r->win.y1 = y1;
+    r->win.y2 = (y2 < orient.lh) ? y2 : (orient.lh - 1);
+    r->mode = mode;
+    pack_region_count++;
+    return true;
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_ClearPackRegions() {
+    pack_region_count = 0;
+}
+
+/* 覆盖 (x, y) 的第一个区域决定模式; 本段在它的右边界或优先级更高的区域起点前结束, 区域都按字节对齐 */
+template <typename Panel>
+epd_pack_mode_t epaper_driver<Panel>::EPD_GetPackMode(uint16_t x, uint16_t y, uint16_t *run_end) {
+    epd_pack_mode_t mode = pack_mode;
+    uint16_t end = orient.lw - 1;
+    for (int i = 0; i < pack_region_count; i++)
+    {
+        const epd_window_t *r = &pack_regions[i].win;
+        if (y < r->y1 || y > r->y2 || r->x2 < x || r->x1 > end)
+        {
+            continue;
+        }
+        if (r->x1 <= x)
+        {
+            mode = pack_regions[i].mode;
+            end = (r->x2 < end) ? r->x2 : end;
+            break;
+        }
+        end = r->x1 - 1;    //当前段在下一个区域起点前结束
+    }
+    if (run_end)
+    {
+        *run_end = end;
+    }
+    return mode;
+}
+
+template <typename Panel>
+uint8_t *epaper_driver<Panel>::EPD_GetFrameBuffer() {
+    return draw_buffer();
+}
+
+/* 不旋转不镜像时直接在面板帧缓冲上绘制, 不需要逻辑画面 */
+template <typename Panel>
+void epaper_driver<Panel>::EPD_SetRotation(epd_rotation_t rot, bool mirror) {
+    epd_orient_init(&orient, Width, Height, rot, mirror);
+    if (epd_orient_identity(&orient))
+    {
+        return;
+    }
+    if (lbuf == NULL)
+    {
+        lbuf = (uint8_t *)heap_caps_malloc(orient.lstride * orient.lh, MALLOC_CAP_SPIRAM);
+        assert(lbuf);
+    }
+    memset(lbuf, 0xff, orient.lstride * orient.lh);
+    EPD_CommitArea(0, 0, orient.lw - 1, orient.lh - 1);
+}
+
+template <typename Panel>
+int epaper_driver<Panel>::EPD_GetWidth() {
+    return orient.lw;
+}
+
+template <typename Panel>
+int epaper_driver<Panel>::EPD_GetHeight() {
+    return orient.lh;
+}
+
+template <typename Panel>
+void epaper_driver<Panel>::EPD_CommitArea(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+    if (lbuf == NULL || epd_orient_identity(&orient))
+    {
+        return;
+    }
+    if (x1 > x2 || y1 > y2 || x2 >= orient.lw || y2 >= orient.lh)
+    {
+        return;
+    }
+    epd_rotate_blit(&orient, lbuf, buffer, x1, y1, x2, y2);
+}
+
+template class epaper_driver<epd_panel_1in54>;
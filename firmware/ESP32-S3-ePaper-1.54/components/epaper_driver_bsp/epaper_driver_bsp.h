@@ -1,8 +1,17 @@
 #ifndef EPAPER_DRIVER_BSP_H
 #define EPAPER_DRIVER_BSP_H
 
-#include "driver/spi_master.h"
-#include "driver/gpio.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "epaper_transport.h"
+#include "epaper_frame_diff.h"
+#include "epaper_refresh_scheduler.h"
+#include "epaper_pack.h"
+#include "epaper_panel.h"
+#include "epaper_rotate.h"
+#include "epaper_frame_store.h"
 
 /* Display color */
 typedef enum {
@@ -11,50 +20,186 @@ typedef enum {
     FONT_BACKGROUND = DRIVER_COLOR_WHITE,
 }COLOR_IMAGE;
 
+#define EPD_PACK_MAX_REGIONS 4      /* 单独指定二值化方式的区域数 */
+#define EPD_SPI_STAGE_EXTRA  512    /* DMA 暂存区在帧缓冲之外的余量, 用于 LUT 等 */
+
+#define EPD_REFRESH_WAIT_MS  100    /* 等待异步刷新完成的兜底超时 */
+#define EPD_REFRESH_MAX_CB   4      /* 一次合并刷新最多携带的完成回调数 */
+#define EPD_IDLE_CHECK_MS    60000  /* 刷新任务空闲时检查安静时段全刷的间隔 */
+#define EPD_LATENCY_ANY      UINT32_MAX /* 请求方不限延迟, 只受合并窗口约束 */
+
+typedef void (*epd_refresh_cb_t)(void *arg);
+
+/* 刷新统计 */
+typedef struct {
+    uint32_t issued;        /* 实际执行的刷新波形次数 */
+    uint32_t skipped;       /* 内容未变化而被丢弃的刷新请求 */
+    uint32_t requests;      /* 内容有变化的刷新请求 */
+    uint32_t merged;        /* 并入已排队刷新的请求, 即省下的刷新次数 */
+    uint32_t deadline_cut;  /* 因请求方的延迟上限早于合并窗口结束而提前发出的刷新 */
+}epd_refresh_stats_t;
+
+#define EPD_TEMP_PERIOD_MS   (10 * 60 * 1000)    /* 刷新前读温度的最小间隔 */
+#define EPD_TEMP_MIN_X16     (-40 * 16)          /* 超出该范围的读数视为读失败 */
+#define EPD_TEMP_MAX_X16     (85 * 16)
+
+/* 面板温度, 供遥测使用 */
 typedef struct {
-    uint8_t cs;
-    uint8_t dc;
-    uint8_t rst;
-    uint8_t busy;
-    uint8_t mosi;
-    uint8_t scl;
-    int spi_host;
-    int buffer_len;
-}custom_lcd_spi_t;
-
-class epaper_driver_display {
+    bool valid;
+    int16_t temp_x16;       /* 1/16 °C */
+    int band;               /* 当前使用的局部波形温度档 */
+    uint32_t reads;
+    uint32_t read_errors;
+}epd_temperature_t;
+
+#define EPD_WAKE_RST_MS      10     /* 从深睡唤醒时的复位脉宽 */
+#define EPD_RAIL_SETTLE_MS   10     /* 供电打开后等待电源稳定 */
+
+/* 控制器电源状态 */
+typedef enum {
+    EPD_POWER_OFF = 0,      /* 断电或状态未知, RAM 内容丢失 */
+    EPD_POWER_SLEEP,        /* 深睡 (0x10 模式 1), RAM 保留, 需硬件复位唤醒 */
+    EPD_POWER_ACTIVE,       /* 已初始化, 可直接刷新 */
+}epd_power_state_t;
+
+typedef void (*epd_power_hook_t)(bool on, void *arg);
+
+/* 电源统计 */
+typedef struct {
+    epd_power_state_t state;
+    uint32_t wakes_from_sleep;
+    uint32_t wakes_from_off;
+    uint32_t last_wake_us;              /* 唤醒序列本身的耗时 */
+    uint32_t last_wake_to_pixels_us;    /* 唤醒开始到随后那次刷新完成 */
+    uint32_t max_wake_to_pixels_us;
+    uint64_t active_us;                 /* 处于 ACTIVE 的累计时间 */
+    uint64_t idle_us;                   /* 深睡或断电的累计时间 */
+}epd_power_stats_t;
+
+/* 异步刷新请求, data 依次存放 diff 中各窗口按行收集好的内容 */
+typedef struct {
+    epd_diff_t diff;
+    uint8_t *data;
+    int len;
+    bool valid;
+    epd_update_class_t cls;
+    uint32_t changed_px;
+    int64_t window_us;      /* 合并窗口结束时间, 由第一个请求决定 */
+    int64_t issue_us;       /* 实际发出时间: 窗口结束与各请求截止时间中最早的 */
+    int cb_count;
+    epd_refresh_cb_t cbs[EPD_REFRESH_MAX_CB];
+    void *args[EPD_REFRESH_MAX_CB];
+}epd_refresh_job_t;
+
+typedef struct {
+    epd_window_t win;
+    epd_pack_mode_t mode;
+}epd_pack_region_t;
+
+/* Panel 为面板参数 (见 epaper_panel.h), 几何尺寸在编译期确定 */
+template <typename Panel>
+class epaper_driver {
+public:
+    static constexpr int Width = Panel::width;
+    static constexpr int Height = Panel::height;
+    static constexpr int Stride = Panel::stride;        /* 帧缓冲每行字节数 */
+
 private:
-    const custom_lcd_spi_t lcd_spi_data;
-    const int Width;
-    const int Height;
-    spi_device_handle_t spi;
+    static constexpr int buffer_len = Panel::fb_bytes;
+    epaper_transport *io;               /* SPI/GPIO 访问全部经过这里 */
+    bool own_io = false;                /* io 由驱动创建, 析构时释放 */
     uint8_t *buffer = NULL;
+    uint8_t *shown = NULL;              /* 屏幕上的帧, 刷新波形结束后才更新 */
+    uint8_t *submitted = NULL;          /* shown 加上进行中和排队中的刷新, 新请求与它做差分 */
+
+    uint8_t *stage = NULL;              /* 内部 RAM 中的 DMA 暂存区 */
+    int stage_cap = 0;
+    int stage_used = 0;
+    uint8_t pending[4];                 /* 尚未发出的 EPD_SendData 字节 */
+    int pending_len = 0;
+
+    SemaphoreHandle_t bus_mux = NULL;           /* 保护 SPI 队列与控制器命令序列 (递归) */
+    SemaphoreHandle_t job_mux = NULL;           /* 保护 jobs */
+    SemaphoreHandle_t refresh_done_sem = NULL;
+    TaskHandle_t refresh_task_handle = NULL;
+    volatile bool stopping = false;             /* 析构中, 刷新任务退出 */
+    epd_refresh_job_t jobs[2] = {};
+    int job_pending = 0;
+    epd_refresh_stats_t refresh_stats = {};   /* 由 job_mux 保护 */
+    epaper_refresh_scheduler *scheduler = NULL;
+    uint32_t coalesce_ms = 0;                   /* 合并窗口, 0 为收到请求立即刷新 */
+    epd_pack_mode_t pack_mode = EPD_PACK_LUMA;  /* 区域之外的二值化方式 */
+    epd_pack_region_t pack_regions[EPD_PACK_MAX_REGIONS];
+    int pack_region_count = 0;
+    epd_orient_t orient;                        /* 逻辑坐标到面板坐标的映射 */
+    uint8_t *lbuf = NULL;                       /* 旋转/镜像时的逻辑画面, 绘制后转写到 buffer */
+
+    epd_power_state_t power_state = EPD_POWER_OFF;
+    epd_waveform_id_t wf_loaded = EPD_WF_NONE;  /* 控制器中当前 LUT 的影子记录 */
+    int wf_band = 0;                            /* 已加载 LUT 对应的温度档 */
+    epd_waveform_stats_t wf_stats[EPD_WF_COUNT] = {};
+    uint8_t lut_buf[EPD_LUT_LEN];               /* 按温度档生成的 LUT */
+    int temp_band = 0;
+    int64_t temp_read_us = 0;
+    epd_temperature_t temp = {};
+    epd_power_hook_t power_hook = NULL;
+    void *power_hook_arg = NULL;
+    uint32_t auto_sleep_ms = 0;
+    bool auto_sleep_rail_off = false;
+    int64_t power_since_us = 0;
+    int64_t wake_start_us = 0;                  /* 非 0 表示唤醒后还没有完成刷新 */
+    epd_power_stats_t power_stats = {};
+    uint8_t *retained = NULL;                   /* 断电前屏幕上的画面, 上电后写回 RAM */
+    epaper_frame_store *frame_store = NULL;
+    bool frame_dirty = false;                   /* shown 在上次保存之后有变化 */
 
-    void spi_gpio_init();
-    void spi_port_init();
     void read_busy();
+    static void refresh_task(void *arg);
 
-    void set_cs_1(){gpio_set_level((gpio_num_t)lcd_spi_data.cs,1);}
-    void set_cs_0(){gpio_set_level((gpio_num_t)lcd_spi_data.cs,0);}
-    void set_dc_1(){gpio_set_level((gpio_num_t)lcd_spi_data.dc,1);}
-    void set_dc_0(){gpio_set_level((gpio_num_t)lcd_spi_data.dc,0);}
-    void set_rst_1(){gpio_set_level((gpio_num_t)lcd_spi_data.rst,1);}
-    void set_rst_0(){gpio_set_level((gpio_num_t)lcd_spi_data.rst,0);}
+    void set_rst_1(){io->set_rst(1);}
+    void set_rst_0(){io->set_rst(0);}
+
+    void spi_queue(uint8_t dc_level, const uint8_t *data, int len);
+    void spi_flush_pending();
+    uint8_t *stage_alloc(int len);
 
-    void SPI_SendByte(uint8_t data);
     void EPD_SendData(uint8_t data);
     void EPD_SendCommand(uint8_t command);
-    void writeBytes(uint8_t *buffer,int len);
     void writeBytes(const uint8_t *buffer, int len);
     void EPD_SetWindows(uint16_t Xstart, uint16_t Ystart, uint16_t Xend, uint16_t Yend);
     void EPD_SetCursor(uint16_t Xstart, uint16_t Ystart);
+    void EPD_SetFullWindow();
     void EPD_SetLut(const uint8_t *lut);
+    void load_waveform(epd_waveform_id_t id);
+    void timed_update(uint8_t ctrl);
+    void enter_partial(epd_waveform_id_t id);
+    bool read_temperature(int16_t *temp_x16);
+    void update_temperature();
     void EPD_TurnOnDisplay();
     void EPD_TurnOnDisplayPart();
+    uint8_t *draw_buffer(){return lbuf ? lbuf : buffer;}
+    bool align_window(epd_window_t *win, uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+    int gather_window(const epd_window_t *win, uint8_t *dst);
+    int gather_diff(const epd_diff_t *diff, uint8_t *dst);
+    void scatter_diff(uint8_t *dst, const epd_diff_t *diff, const uint8_t *data);
+    void write_window_ram(uint8_t ram, const epd_window_t *win, const uint8_t *data, int len);
+    void write_diff_ram(uint8_t ram, const epd_diff_t *diff, const uint8_t *data);
+    void refresh_diff(const epd_diff_t *diff, const uint8_t *data, epd_waveform_id_t wf);
+    void refresh_full_frame(const epd_diff_t *diff = NULL, const uint8_t *data = NULL);
+    void set_power_state(epd_power_state_t state);
+    void count_wake(epd_power_state_t from, int64_t t0);
+    void power_up(epd_waveform_id_t wf);
+    void power_down(bool rail_off);
+    void mark_pixels_done();
+    void restore_ram();
+    void persist_frame(bool force);
 
 public:
-    epaper_driver_display(int width, int height,custom_lcd_spi_t _lcd_spi_data);
-    ~epaper_driver_display();
+#if !CONFIG_IDF_TARGET_LINUX
+    epaper_driver(custom_lcd_spi_t _lcd_spi_data);     /* 板上 SPI */
+#endif
+    epaper_driver(epaper_transport *transport);
+    ~epaper_driver();
 
     void EPD_Init();    /* 墨水屏初始化 */
     void EPD_Clear();   /* 清空屏幕 */
@@ -64,6 +209,47 @@ public:
     void EPD_DisplayPartBaseImage();
     void EPD_Init_Partial();
     void EPD_DisplayPart();
+    void EPD_DisplayPartWindow(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2); /* 只刷新字节对齐的矩形窗口 */
+    void EPD_RefreshAsync(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, epd_refresh_cb_t cb, void *arg,
+                          epd_update_class_t cls = EPD_UPDATE_NORMAL,
+                          uint32_t max_delay_ms = EPD_LATENCY_ANY); /* 非阻塞窗口刷新, max_delay_ms 为请求方能容忍的最长等待 */
+    void EPD_SetCoalesceWindow(uint32_t ms);    /* 第一个请求到达后最多等 ms, 期间的请求合并为一次刷新 */
+    void EPD_RefreshWait();
+    void EPD_GetRefreshStats(epd_refresh_stats_t *stats);
+    void EPD_GetWaveformStats(epd_waveform_id_t id, epd_waveform_stats_t *stats);
+    void EPD_GetTemperature(epd_temperature_t *out);
+    void EPD_FullRefresh();     /* 用全刷波形重画已提交的整帧, 清除残影 */
+    void EPD_SetScheduler(epaper_refresh_scheduler *sched);
+    void EPD_SetFrameStore(epaper_frame_store *store);     /* 空闲时把屏幕上的帧存到 flash */
+    bool EPD_RestoreFrame();    /* 开机时代替 Init/Clear/DisplayPartBaseImage: 读回上次的帧写入控制器 RAM, 不刷新屏幕 */
+
+    /*电源管理*/
+    void EPD_SetPowerHook(epd_power_hook_t hook, void *arg);   /* 面板供电开关, 断电休眠时使用 */
+    void EPD_SetAutoSleep(uint32_t idle_ms, bool rail_off);     /* 空闲 idle_ms 后自动休眠, 0 关闭 */
+    void EPD_Sleep(bool rail_off);                              /* 等待刷新完成后立即休眠 */
+    void EPD_GetPowerStats(epd_power_stats_t *stats);
     void EPD_DrawColorPixel(uint16_t x, uint16_t y,uint8_t color);
+    void EPD_DrawRGB565Area(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, const uint16_t *src); /* x1 需 8 对齐 */
+    void EPD_SetPackMode(epd_pack_mode_t mode);
+    bool EPD_AddPackRegion(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, epd_pack_mode_t mode); /* 先添加的优先 */
+    void EPD_ClearPackRegions();
+    epd_pack_mode_t EPD_GetPackMode(uint16_t x, uint16_t y, uint16_t *run_end = NULL); /* run_end: 该模式在本行延续到的 X */
+    uint8_t *EPD_GetFrameBuffer();  /* 按逻辑坐标绘制的 1bpp 缓冲, 每行 (EPD_GetWidth()+7)/8 字节, 1 为白 */
+
+    /*方向, 在开始绘制前设置; 之后绘制和刷新接口的坐标都是逻辑坐标*/
+    void EPD_SetRotation(epd_rotation_t rot, bool mirror);
+    int EPD_GetWidth();     /* 逻辑宽高, 旋转 90/270 时与面板互换 */
+    int EPD_GetHeight();
+    void EPD_CommitArea(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2); /* 直接写 EPD_GetFrameBuffer() 后调用, 把该区域转写到面板帧缓冲 */
+
+    /*SPI 队列*/
+    uint32_t EPD_SpiFence(epd_spi_done_cb_t cb, void *arg); /* 返回已排队传输的票据, cb 在中断上下文调用 */
+    void EPD_SpiWait(uint32_t ticket);                      /* 等待票据对应的传输全部完成 */
+    void EPD_GetSpiStats(epd_spi_stats_t *stats);
 };
+
+/* 成员函数在 epaper_driver_bsp.cpp 中定义并显式实例化 */
+extern template class epaper_driver<epd_panel_1in54>;
+
+typedef epaper_driver<epd_panel_1in54> epaper_driver_display;
 #endif
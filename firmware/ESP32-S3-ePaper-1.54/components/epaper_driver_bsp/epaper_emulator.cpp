@@ -0,0 +1,423 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "epaper_emulator.h"
+#include "esp_log.h"
+
+static const char *TAG = "epd_emu";
+
+/* SSD1681 LUT 布局: 5 x 12 字节 VS, 之后 12 组 TP/SR/RP (每组 7 字节), 再是 FR 和 XON */
+#define EMU_LUT_GROUPS      12
+#define EMU_LUT_TP_OFFSET   60
+
+static const epd_emu_timing_t emu_default_timing = {
+    40 * 1000 * 1000,   /* spi_hz */
+    5,                  /* xfer_us */
+    1000,               /* reset_us */
+    2000,               /* swreset_us */
+    20000,              /* frame_us, 50 Hz */
+    2000000,            /* otp_update_us */
+    1000,               /* ctrl_us */
+    100,                /* lut_us */
+    25 * 16,            /* temp_x16 */
+};
+
+epaper_emulator::epaper_emulator(int width, int height, const epd_emu_timing_t *t) :
+    ram_w((width + 7) >> 3),
+    ram_h(height) {
+    timing = t ? *t : emu_default_timing;
+    const int len = ram_w * ram_h;
+    ram_bw = (uint8_t *)malloc(len);
+    ram_red = (uint8_t *)malloc(len);
+    panel = (uint8_t *)malloc(len);
+    assert(ram_bw && ram_red && panel);
+    memset(ram_bw, 0x00, len);
+    memset(ram_red, 0x00, len);
+    memset(panel, 0xff, len);
+    reset_regs();
+}
+
+epaper_emulator::~epaper_emulator() {
+    free(ram_bw);
+    free(ram_red);
+    free(panel);
+}
+
+/* 硬件复位和 0x12 之后的寄存器默认值; RAM 不受影响 */
+void epaper_emulator::reset_regs() {
+    cmd = 0;
+    param_idx = 0;
+    entry_mode = 0x03;
+    gate_scan = 0;
+    x_start = 0;
+    x_end = ram_w - 1;
+    y_start = 0;
+    y_end = ram_h - 1;
+    x_cnt = 0;
+    y_cnt = 0;
+    wr_ram = NULL;
+    lut_loaded = false;
+    update_ctrl = 0xff;
+    sleeping = false;
+}
+
+void epaper_emulator::queue(uint8_t dc_level, const uint8_t *data, int len) {
+    stats.transactions++;
+    stats.bytes += len;
+    stats.sim_us += timing.xfer_us + (uint64_t)len * 8 * 1000000 / timing.spi_hz;
+    seq++;
+
+    for (int i = 0; i < len; i++)
+    {
+        if (!powered || sleeping || rst_low)
+        {
+            stats.sleep_violations++;
+            return;
+        }
+        if (dc_level == 0)
+        {
+            if (stats.sim_us < busy_until)
+            {
+                stats.busy_violations++;
+                ESP_LOGW(TAG, "Command 0x%02x while BUSY", data[i]);
+            }
+            command(data[i]);
+        }
+        else
+        {
+            param(data[i]);
+        }
+    }
+}
+
+void epaper_emulator::command(uint8_t c) {
+    stats.commands++;
+    cmd = c;
+    param_idx = 0;
+    wr_ram = NULL;
+    switch (c)
+    {
+    case 0x12:  //SWRESET
+        reset_regs();
+        busy_until = stats.sim_us + timing.swreset_us;
+        break;
+    case 0x20:
+        master_activation();
+        break;
+    case 0x24:
+        wr_ram = ram_bw;
+        break;
+    case 0x26:
+        wr_ram = ram_red;
+        break;
+    case 0x01: case 0x03: case 0x04: case 0x10: case 0x11: case 0x18: case 0x22:
+    case 0x2C: case 0x32: case 0x37: case 0x3C: case 0x3F:
+    case 0x44: case 0x45: case 0x4E: case 0x4F:
+        break;
+    default:
+        stats.unknown_cmds++;
+        ESP_LOGW(TAG, "Unknown command 0x%02x", c);
+        break;
+    }
+}
+
+/* X 先走; 计数器到达窗口终点后回到起点, 另一个方向走一步 */
+void epaper_emulator::ram_write(uint8_t d) {
+    if (x_cnt >= 0 && x_cnt < ram_w && y_cnt >= 0 && y_cnt < ram_h)
+    {
+        wr_ram[y_cnt * ram_w + x_cnt] = d;
+    }
+    const int dx = (entry_mode & 0x01) ? 1 : -1;
+    const int dy = (entry_mode & 0x02) ? 1 : -1;
+    if (x_cnt != x_end)
+    {
+        x_cnt += dx;
+        return;
+    }
+    x_cnt = x_start;
+    y_cnt = (y_cnt == y_end) ? y_start : y_cnt + dy;
+}
+
+void epaper_emulator::param(uint8_t d) {
+    if (wr_ram)
+    {
+        ram_write(d);
+        return;
+    }
+    const int i = param_idx++;
+    if (i < (int)sizeof(params))
+    {
+        params[i] = d;
+    }
+    switch (cmd)
+    {
+    case 0x01:
+        if (i == 2)
+        {
+            gate_scan = d;
+        }
+        break;
+    case 0x10:
+        if (d & 0x03)
+        {
+            sleeping = true;    //深睡: 之后只有硬件复位能唤醒
+            busy_until = UINT64_MAX;
+        }
+        break;
+    case 0x11:
+        entry_mode = d & 0x07;
+        break;
+    case 0x22:
+        update_ctrl = d;
+        break;
+    case 0x32:
+        if (i < (int)sizeof(lut))
+        {
+            lut[i] = d;
+        }
+        if (i == (int)sizeof(lut) - 1)
+        {
+            lut_loaded = true;
+            stats.lut_uploads++;
+            busy_until = stats.sim_us + timing.lut_us;
+        }
+        break;
+    case 0x44:
+        if (i == 0)
+        {
+            x_start = d & 0x3f;
+        }
+        else if (i == 1)
+        {
+            x_end = d & 0x3f;
+        }
+        break;
+    case 0x45:
+        if (i == 1)
+        {
+            y_start = (params[0] | (params[1] << 8)) & 0x1ff;
+        }
+        else if (i == 3)
+        {
+            y_end = (params[2] | (params[3] << 8)) & 0x1ff;
+        }
+        break;
+    case 0x4E:
+        x_cnt = d & 0x3f;
+        break;
+    case 0x4F:
+        if (i == 1)
+        {
+            y_cnt = (params[0] | (params[1] << 8)) & 0x1ff;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* 12 组各 4 个相位的帧数之和乘以重复次数 */
+uint32_t epaper_emulator::lut_frames() {
+    uint32_t frames = 0;
+    for (int g = 0; g < EMU_LUT_GROUPS; g++)
+    {
+        const uint8_t *p = &lut[EMU_LUT_TP_OFFSET + g * 7];
+        frames += (uint32_t)(p[0] + p[1] + p[3] + p[4]) * (p[6] + 1);
+    }
+    return frames;
+}
+
+/* Mode 1 按 0x24 驱动全部像素; Mode 2 只驱动 0x24 与 0x26 不同的像素, 其余保持面板原样 */
+void epaper_emulator::refresh_panel(bool mode2) {
+    const int len = ram_w * ram_h;
+    uint32_t driven = 0;
+    uint32_t stale = 0;
+    for (int i = 0; i < len; i++)
+    {
+        const uint8_t mask = mode2 ? (uint8_t)(ram_bw[i] ^ ram_red[i]) : 0xff;
+        panel[i] = (panel[i] & ~mask) | (ram_bw[i] & mask);
+        driven += __builtin_popcount(mask);
+        stale += __builtin_popcount((uint8_t)(panel[i] ^ ram_bw[i]));
+    }
+    last.driven_px = driven;
+    last.stale_px = stale;
+}
+
+/*
+ * 0x22 各位: 7 开时钟, 6 开模拟电源, 5 测温, 4 从 OTP 载入 LUT, 3 Display Mode 2, 2 显示, 1 关模拟电源, 0 关时钟.
+ */
+void epaper_emulator::master_activation() {
+    const uint8_t ctrl = update_ctrl;
+    if (ctrl & 0x10)
+    {
+        lut_loaded = false;     //换成 OTP 波形
+    }
+    if (!(ctrl & 0x04))
+    {
+        busy_until = stats.sim_us + timing.ctrl_us;
+        return;
+    }
+
+    const bool mode2 = ctrl & 0x08;
+    const uint32_t frames = lut_loaded ? lut_frames() : 0;
+    const uint32_t busy_us = lut_loaded ? frames * timing.frame_us : timing.otp_update_us;
+    refresh_panel(mode2);
+    busy_until = stats.sim_us + busy_us;
+
+    stats.updates++;
+    if (mode2)
+    {
+        stats.partial_updates++;
+    }
+    last.partial = mode2;
+    last.frames = frames;
+    last.busy_us = busy_us;
+    last.bytes = stats.bytes - mark.bytes;
+    last.transactions = stats.transactions - mark.transactions;
+    last.sim_us = busy_until - mark.sim_us;
+    mark = stats;
+    mark.sim_us = busy_until;
+    ESP_LOGD(TAG, "Update %s: %lu B in %lu xfers, %lu frames, %lu px driven, %llu us",
+             mode2 ? "mode2" : "mode1", (unsigned long)last.bytes, (unsigned long)last.transactions,
+             (unsigned long)frames, (unsigned long)last.driven_px, (unsigned long long)last.sim_us);
+    if (last.stale_px)
+    {
+        ESP_LOGW(TAG, "%lu px differ from RAM 0x24 after update", (unsigned long)last.stale_px);
+    }
+}
+
+uint32_t epaper_emulator::fence(epd_spi_done_cb_t cb, void *arg) {
+    if (cb)
+    {
+        cb(arg);    //传输同步完成
+    }
+    return seq;
+}
+
+void epaper_emulator::wait(uint32_t ticket) {
+}
+
+void epaper_emulator::set_rst(int level) {
+    if (level == 0)
+    {
+        rst_low = true;
+        return;
+    }
+    if (rst_low && powered)
+    {
+        stats.resets++;
+        reset_regs();
+        busy_until = stats.sim_us + timing.reset_us;
+    }
+    rst_low = false;
+}
+
+void epaper_emulator::wait_busy() {
+    if (busy_until == UINT64_MAX)
+    {
+        ESP_LOGE(TAG, "Waiting for BUSY in deep sleep");
+        stats.sleep_violations++;
+        return;
+    }
+    if (stats.sim_us < busy_until)
+    {
+        stats.sim_us = busy_until;
+    }
+}
+
+bool epaper_emulator::read(uint8_t c, uint8_t *data, int len) {
+    if (!powered || sleeping || rst_low || len > 2)
+    {
+        return false;
+    }
+    stats.sim_us += timing.xfer_us * 2;
+    if (c == 0x1B)
+    {
+        const uint16_t raw = (uint16_t)(timing.temp_x16 << 4);
+        data[0] = raw >> 8;
+        if (len > 1)
+        {
+            data[1] = raw & 0xff;
+        }
+        return true;
+    }
+    memset(data, 0, len);
+    return true;
+}
+
+void epaper_emulator::delay_ms(uint32_t ms) {
+    stats.sim_us += (uint64_t)ms * 1000;
+}
+
+void epaper_emulator::get_stats(epd_spi_stats_t *out) {
+    out->bytes = stats.bytes;
+    out->transactions = stats.transactions;
+}
+
+/* 断电: 控制器 RAM 和寄存器丢失, 电子纸上的画面不变 */
+void epaper_emulator::set_power(bool on) {
+    if (on && !powered)
+    {
+        memset(ram_bw, 0x00, ram_w * ram_h);
+        memset(ram_red, 0x00, ram_w * ram_h);
+        reset_regs();
+        busy_until = stats.sim_us + timing.reset_us;
+    }
+    powered = on;
+}
+
+void epaper_emulator::set_temperature(int16_t temp_x16) {
+    timing.temp_x16 = temp_x16;
+}
+
+void epaper_emulator::get_emu_stats(epd_emu_stats_t *out) {
+    *out = stats;
+}
+
+void epaper_emulator::get_last_update(epd_emu_update_t *out) {
+    *out = last;
+}
+
+/* 0x01 第三个参数 bit0 (TB) 决定 RAM Y 地址与扫描行的对应方向 */
+bool epaper_emulator::pixel(int x, int y) {
+    if (x < 0 || y < 0 || x >= ram_w * 8 || y >= ram_h)
+    {
+        return true;
+    }
+    const int ry = (gate_scan & 0x01) ? ram_h - 1 - y : y;
+    return (panel[ry * ram_w + (x >> 3)] >> (7 - (x & 0x07))) & 0x01;
+}
+
+bool epaper_emulator::read_ram(uint8_t ram, uint8_t *out) {
+    const uint8_t *src = (ram == 0x24) ? ram_bw : (ram == 0x26) ? ram_red : (ram == 0) ? panel : NULL;
+    if (src == NULL)
+    {
+        return false;
+    }
+    for (int y = 0; y < ram_h; y++)
+    {
+        const int ry = (gate_scan & 0x01) ? ram_h - 1 - y : y;
+        memcpy(out + y * ram_w, src + ry * ram_w, ram_w);
+    }
+    return true;
+}
+
+bool epaper_emulator::dump_pbm(const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+    {
+        ESP_LOGE(TAG, "Open %s failed", path);
+        return false;
+    }
+    fprintf(f, "P4\n%d %d\n", ram_w * 8, ram_h);
+    for (int y = 0; y < ram_h; y++)
+    {
+        const int ry = (gate_scan & 0x01) ? ram_h - 1 - y : y;
+        for (int x = 0; x < ram_w; x++)
+        {
+            fputc((uint8_t)~panel[ry * ram_w + x], f);  //PBM 中 1 为黑
+        }
+    }
+    return fclose(f) == 0;
+}
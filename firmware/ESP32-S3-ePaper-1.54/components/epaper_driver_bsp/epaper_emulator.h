@@ -0,0 +1,118 @@
+#ifndef EPAPER_EMULATOR_H
+#define EPAPER_EMULATOR_H
+
+#include "epaper_transport.h"
+
+/*
+ * 主机 (IDF linux 目标) 上的 SSD1681 模拟器, 作为 epaper_transport 接到驱动下面:
+ *     epaper_emulator *emu = new epaper_emulator(epaper_driver_display::Width, epaper_driver_display::Height);
+ *     driver = new epaper_driver_display(emu);
+ * 解释驱动发出的命令流 (0x01 0x10 0x11 0x12 0x18 0x1B 0x20 0x22 0x24 0x26 0x32 0x3C 0x44 0x45 0x4E 0x4F,
+ * 其余 LUT 相关寄存器只记录不解释), 维护两块 RAM 和面板上实际显示的内容, 按时序模型推进模拟时间.
+ * 所有操作同步完成, 不需要真实等待.
+ */
+
+/* 时序模型, 单位 us */
+typedef struct {
+    uint32_t spi_hz;            /* 按此时钟折算传输时间 */
+    uint32_t xfer_us;           /* 每个传输的固定开销 (DC 切换, 中断) */
+    uint32_t reset_us;          /* 硬件复位释放后 BUSY 为高的时间 */
+    uint32_t swreset_us;        /* 0x12 */
+    uint32_t frame_us;          /* 波形一帧; 已上传 LUT 时刷新时间 = LUT 总帧数 * frame_us */
+    uint32_t otp_update_us;     /* 没有上传 LUT (使用 OTP 波形) 时的刷新时间 */
+    uint32_t ctrl_us;           /* 不带显示的 0x20 (测温, 开模拟电源等) */
+    uint32_t lut_us;            /* 0x32 写入后 BUSY 为高的时间 */
+    int16_t temp_x16;           /* 0x1B 读回的温度, 1/16 °C */
+}epd_emu_timing_t;
+
+/* 累计统计 */
+typedef struct {
+    uint32_t bytes;
+    uint32_t transactions;
+    uint32_t commands;
+    uint32_t updates;           /* 带显示的 0x20 次数 */
+    uint32_t partial_updates;   /* 其中 Display Mode 2 (按 0x26 -> 0x24 只驱动变化像素) */
+    uint32_t lut_uploads;
+    uint32_t resets;
+    uint32_t unknown_cmds;
+    uint32_t busy_violations;   /* BUSY 为高时发出的命令 */
+    uint32_t sleep_violations;  /* 深睡或断电时发出的命令 */
+    uint64_t sim_us;            /* 模拟时间 */
+}epd_emu_stats_t;
+
+/* 一次刷新 (带显示的 0x20) 的开销, 从上一次刷新结束算起 */
+typedef struct {
+    bool partial;
+    uint32_t bytes;
+    uint32_t transactions;
+    uint32_t frames;            /* LUT 总帧数, 0 表示 OTP 波形 */
+    uint32_t busy_us;           /* 波形本身 */
+    uint32_t driven_px;         /* 实际被驱动的像素 */
+    uint32_t stale_px;          /* 刷新后显示内容与 0x24 不一致的像素, 旧图 RAM 与屏幕不同步时出现 */
+    uint64_t sim_us;            /* 含写 RAM, 设置寄存器和等待 */
+}epd_emu_update_t;
+
+class epaper_emulator : public epaper_transport {
+private:
+    const int ram_w;            /* 字节 */
+    const int ram_h;
+    epd_emu_timing_t timing;
+    uint8_t *ram_bw;            /* 0x24 */
+    uint8_t *ram_red;           /* 0x26 */
+    uint8_t *panel;             /* 面板显示的内容, 断电也保持 */
+
+    bool powered = true;
+    bool rst_low = false;
+    bool sleeping = false;
+    uint64_t busy_until = 0;
+    uint8_t cmd = 0;
+    int param_idx = 0;
+    uint8_t params[8];
+    uint8_t lut[153];
+    bool lut_loaded = false;
+    uint8_t update_ctrl = 0;
+    uint8_t entry_mode = 0x03;
+    uint8_t gate_scan = 0;      /* 0x01 第三个参数 */
+    int x_start = 0, x_end = 0, x_cnt = 0;
+    int y_start = 0, y_end = 0, y_cnt = 0;
+    uint8_t *wr_ram = NULL;     /* 正在写入的 RAM */
+
+    uint32_t seq = 0;
+    epd_emu_stats_t stats = {};
+    epd_emu_stats_t mark = {};  /* 上一次刷新结束时的统计, 用于计算单次开销 */
+    epd_emu_update_t last = {};
+
+    void reset_regs();
+    void command(uint8_t c);
+    void param(uint8_t d);
+    void ram_write(uint8_t d);
+    void master_activation();
+    uint32_t lut_frames();
+    void refresh_panel(bool mode2);
+
+public:
+    epaper_emulator(int width, int height, const epd_emu_timing_t *t = NULL);
+    ~epaper_emulator();
+
+    void queue(uint8_t dc_level, const uint8_t *data, int len) override;
+    uint32_t fence(epd_spi_done_cb_t cb, void *arg) override;
+    void wait(uint32_t ticket) override;
+    void set_rst(int level) override;
+    void wait_busy() override;
+    bool read(uint8_t cmd, uint8_t *data, int len) override;
+    void delay_ms(uint32_t ms) override;
+    void get_stats(epd_spi_stats_t *stats) override;
+
+    void set_power(bool on);    /* 接到驱动的电源钩子上; 断电后 RAM 丢失, 面板内容保持 */
+    void set_temperature(int16_t temp_x16);
+    void get_emu_stats(epd_emu_stats_t *out);
+    void get_last_update(epd_emu_update_t *out);
+    /* 面板 (x, y) 是否为白, 坐标与驱动帧缓冲一致 */
+    bool pixel(int x, int y);
+    /* 按驱动帧缓冲的排列 (每行 (width+7)/8 字节) 拷出 RAM 0x24/0x26 或面板当前显示的内容 (ram 为 0) */
+    bool read_ram(uint8_t ram, uint8_t *out);
+    /* 把面板当前显示的内容写成 PBM (P4) */
+    bool dump_pbm(const char *path);
+};
+
+#endif
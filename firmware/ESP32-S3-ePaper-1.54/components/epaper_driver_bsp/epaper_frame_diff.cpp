@@ -0,0 +1,74 @@
+#include <string.h>
+#include "epaper_frame_diff.h"
+
+static void window_union(epd_window_t *dst, const epd_window_t *src) {
+    if (src->x1 < dst->x1) dst->x1 = src->x1;
+    if (src->y1 < dst->y1) dst->y1 = src->y1;
+    if (src->x2 > dst->x2) dst->x2 = src->x2;
+    if (src->y2 > dst->y2) dst->y2 = src->y2;
+}
+
+void epd_diff_add_band(epd_diff_t *diff, const epd_window_t *win) {
+    epd_window_t w = *win;
+
+    /* 吸收所有与 w 重叠或相距不足 EPD_DIFF_BAND_GAP 行的窗口 */
+    int i = 0;
+    while (i < diff->count)
+    {
+        const epd_window_t *b = &diff->bands[i];
+        if (w.y1 <= b->y2 + EPD_DIFF_BAND_GAP && b->y1 <= w.y2 + EPD_DIFF_BAND_GAP)
+        {
+            window_union(&w, b);
+            memmove(&diff->bands[i], &diff->bands[i + 1], (diff->count - i - 1) * sizeof(epd_window_t));
+            diff->count--;
+            i = 0;
+            continue;
+        }
+        i++;
+    }
+
+    /* 按 y1 升序插入 */
+    epd_window_t bands[EPD_DIFF_MAX_BANDS + 1];
+    int n = 0;
+    bool inserted = false;
+    for (i = 0; i < diff->count; i++)
+    {
+        if (!inserted && w.y1 < diff->bands[i].y1)
+        {
+            bands[n++] = w;
+            inserted = true;
+        }
+        bands[n++] = diff->bands[i];
+    }
+    if (!inserted)
+    {
+        bands[n++] = w;
+    }
+
+    /* 段数超限时合并间距最小的相邻两段 */
+    while (n > EPD_DIFF_MAX_BANDS)
+    {
+        int best = 0;
+        int best_gap = bands[1].y1 - bands[0].y2;
+        for (i = 1; i < n - 1; i++)
+        {
+            int gap = bands[i + 1].y1 - bands[i].y2;
+            if (gap < best_gap)
+            {
+                best_gap = gap;
+                best = i;
+            }
+        }
+        window_union(&bands[best], &bands[best + 1]);
+        memmove(&bands[best + 1], &bands[best + 2], (n - best - 2) * sizeof(epd_window_t));
+        n--;
+    }
+
+    memcpy(diff->bands, bands, n * sizeof(epd_window_t));
+    diff->count = n;
+    diff->bbox = bands[0];
+    for (i = 1; i < n; i++)
+    {
+        window_union(&diff->bbox, &bands[i]);
+    }
+}
@@ -0,0 +1,124 @@
+#ifndef EPAPER_FRAME_DIFF_H
+#define EPAPER_FRAME_DIFF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EPD_DIFF_MAX_BANDS   4      /* 一次刷新最多写入的独立 RAM 窗口数 */
+#define EPD_DIFF_BAND_GAP    8      /* 相距不超过该行数的脏行合并为同一个窗口 */
+
+/* 字节对齐后的刷新窗口, 坐标为 buffer 像素坐标 (含端点) */
+typedef struct {
+    uint16_t x1;
+    uint16_t y1;
+    uint16_t x2;
+    uint16_t y2;
+}epd_window_t;
+
+/* 差分结果: 按行分段的脏窗口 (按 y1 升序且互不重叠) 及其外接矩形 */
+typedef struct {
+    int count;
+    epd_window_t bands[EPD_DIFF_MAX_BANDS];
+    epd_window_t bbox;
+    uint32_t changed_px;    /* 变化的像素数 */
+}epd_diff_t;
+
+/* 把窗口并入 diff, 与已有窗口重叠或相邻时合并, 超出 EPD_DIFF_MAX_BANDS 时合并间距最小的两段 */
+void epd_diff_add_band(epd_diff_t *diff, const epd_window_t *win);
+
+/* 逐行累积脏字节, 行间距超过 EPD_DIFF_BAND_GAP 时结束当前段 */
+typedef struct {
+    epd_diff_t *out;
+    epd_window_t band;
+    bool open;
+}epd_band_builder_t;
+
+static inline void epd_band_mark(epd_band_builder_t *bb, int row, int col) {
+    const uint16_t x1 = col << 3;
+    const uint16_t x2 = x1 + 7;
+    if (bb->open && row <= bb->band.y2 + EPD_DIFF_BAND_GAP)
+    {
+        if (x1 < bb->band.x1) bb->band.x1 = x1;
+        if (x2 > bb->band.x2) bb->band.x2 = x2;
+        bb->band.y2 = row;
+        return;
+    }
+    if (bb->open)
+    {
+        epd_diff_add_band(bb->out, &bb->band);
+    }
+    bb->band.x1 = x1;
+    bb->band.x2 = x2;
+    bb->band.y1 = row;
+    bb->band.y2 = row;
+    bb->open = true;
+}
+
+/*
+ * 在 req 窗口内逐字 (32bit) 异或 shown 与 frame, 得到真正变化的行段.
+ * 两个缓冲都必须 4 字节对齐, 每行 (width+7)/8 字节. 没有任何变化时返回 false.
+ * 放在头文件中内联, width/height 为编译期常量时行号/列号的除法按固定步长展开.
+ */
+static inline bool epd_frame_diff(const uint8_t *shown, const uint8_t *frame, int width, int height,
+                                  const epd_window_t *req, epd_diff_t *out) {
+    const int stride = (width + 7) >> 3;
+    const int bx1 = req->x1 >> 3;
+    const int bx2 = req->x2 >> 3;
+    const int first = req->y1 * stride + bx1;
+    const int last = req->y2 * stride + bx2;
+    const int words_end = (stride * height) >> 2;     //完整 32bit 字的个数
+
+    epd_band_builder_t bb = {};
+    bb.out = out;
+    out->count = 0;
+    out->changed_px = 0;
+
+    const uint32_t *a = (const uint32_t *)shown;
+    const uint32_t *b = (const uint32_t *)frame;
+    int w = first >> 2;
+    for (; w <= (last >> 2) && w < words_end; w++)
+    {
+        uint32_t x = a[w] ^ b[w];
+        if (x == 0)
+        {
+            continue;
+        }
+        for (int k = 0; k < 4; k++, x >>= 8)
+        {
+            if ((x & 0xff) == 0)
+            {
+                continue;
+            }
+            const int off = (w << 2) + k;
+            const int row = off / stride;
+            const int col = off - row * stride;
+            if (off >= first && off <= last && col >= bx1 && col <= bx2)
+            {
+                out->changed_px += __builtin_popcount(x & 0xff);
+                epd_band_mark(&bb, row, col);
+            }
+        }
+    }
+    /* 行宽不是 4 的倍数时, 末尾不足一个字的部分逐字节比较 */
+    for (int off = w << 2; off <= last; off++)
+    {
+        if (shown[off] != frame[off])
+        {
+            const int row = off / stride;
+            const int col = off - row * stride;
+            if (col >= bx1 && col <= bx2)
+            {
+                out->changed_px += __builtin_popcount(shown[off] ^ frame[off]);
+                epd_band_mark(&bb, row, col);
+            }
+        }
+    }
+
+    if (bb.open)
+    {
+        epd_diff_add_band(out, &bb.band);
+    }
+    return out->count > 0;
+}
+
+#endif
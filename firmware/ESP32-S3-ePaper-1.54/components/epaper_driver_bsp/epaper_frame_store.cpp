@@ -0,0 +1,177 @@
+#include <stddef.h>
+#include <string.h>
+#include "epaper_frame_store.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+
+static const char *TAG = "epd_store";
+
+#define STORE_MAX_SLOTS   16
+
+epaper_frame_store::epaper_frame_store(const char *label, int _width, int _height, int _frame_len, uint32_t _min_interval_s) :
+    width(_width),
+    height(_height),
+    frame_len(_frame_len),
+    min_interval_s(_min_interval_s) {
+
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (part == NULL)
+    {
+        ESP_LOGW(TAG, "Partition '%s' not found, frame persistence disabled", label);
+        return;
+    }
+    const uint32_t need = EPD_STORE_DATA_OFS + frame_len;
+    slot_size = (need + part->erase_size - 1) / part->erase_size * part->erase_size;
+    slots = part->size / slot_size;
+    if (slots > STORE_MAX_SLOTS)
+    {
+        slots = STORE_MAX_SLOTS;
+    }
+    if (slots < 2)
+    {
+        ESP_LOGW(TAG, "Partition '%s' too small for %d-byte frames", label, frame_len);
+        part = NULL;
+        return;
+    }
+    scan();
+}
+
+bool epaper_frame_store::ready() {
+    return part != NULL;
+}
+
+static uint32_t hdr_crc(const epd_store_hdr_t *hdr) {
+    return esp_rom_crc32_le(0, (const uint8_t *)hdr, offsetof(epd_store_hdr_t, hdr_crc));
+}
+
+/* 头本身完整且与当前面板几何一致 */
+bool epaper_frame_store::read_hdr(int slot, epd_store_hdr_t *hdr) {
+    if (esp_partition_read(part, slot * slot_size, hdr, sizeof(*hdr)) != ESP_OK)
+    {
+        return false;
+    }
+    return hdr->magic == EPD_STORE_MAGIC && hdr->version == EPD_STORE_VERSION &&
+           hdr->width == width && hdr->height == height && hdr->len == (uint32_t)frame_len &&
+           hdr->hdr_crc == hdr_crc(hdr);
+}
+
+/* 找到序号最大的有效头, 之后的保存接着写在它后面的槽, 序号继续递增 */
+void epaper_frame_store::scan() {
+    epd_store_hdr_t hdr;
+    uint32_t max_seq = 0;
+    for (int i = 0; i < slots; i++)
+    {
+        if (read_hdr(i, &hdr) && hdr.seq > max_seq)
+        {
+            max_seq = hdr.seq;
+            next_slot = (i + 1) % slots;
+        }
+    }
+    seq = max_seq + 1;
+}
+
+/* 从序号最大的槽开始找, 数据 CRC 不对 (写到一半掉电) 就退回上一帧 */
+bool epaper_frame_store::load(uint8_t *frame) {
+    if (!ready())
+    {
+        return false;
+    }
+    epd_store_hdr_t hdrs[STORE_MAX_SLOTS];
+    bool valid[STORE_MAX_SLOTS];
+    for (int i = 0; i < slots; i++)
+    {
+        valid[i] = read_hdr(i, &hdrs[i]);
+    }
+
+    for (;;)
+    {
+        int best = -1;
+        for (int i = 0; i < slots; i++)
+        {
+            if (valid[i] && (best < 0 || hdrs[i].seq > hdrs[best].seq))
+            {
+                best = i;
+            }
+        }
+        if (best < 0)
+        {
+            return false;
+        }
+        valid[best] = false;
+        if (esp_partition_read(part, best * slot_size + EPD_STORE_DATA_OFS, frame, frame_len) != ESP_OK)
+        {
+            continue;
+        }
+        const uint32_t crc = esp_rom_crc32_le(0, frame, frame_len);
+        if (crc != hdrs[best].crc)
+        {
+            ESP_LOGW(TAG, "Slot %d (seq %lu) corrupt", best, (unsigned long)hdrs[best].seq);
+            continue;
+        }
+        last_crc = crc;
+        have_last = true;
+        stats.seq = hdrs[best].seq;
+        ESP_LOGI(TAG, "Restored frame seq %lu from slot %d", (unsigned long)hdrs[best].seq, best);
+        return true;
+    }
+}
+
+bool epaper_frame_store::save(const uint8_t *frame, bool force) {
+    if (!ready())
+    {
+        return false;
+    }
+    const uint32_t crc = esp_rom_crc32_le(0, frame, frame_len);
+    if (have_last && crc == last_crc)
+    {
+        stats.skipped_same++;
+        return true;
+    }
+    const int64_t now = esp_timer_get_time();
+    if (!force && have_last && now - last_save_us < (int64_t)min_interval_s * 1000000)
+    {
+        stats.skipped_rate++;
+        return false;
+    }
+
+    const uint32_t ofs = next_slot * slot_size;
+    epd_store_hdr_t hdr = {};
+        hdr.magic = EPD_STORE_MAGIC;
+        hdr.version = EPD_STORE_VERSION;
+        hdr.width = width;
+        hdr.height = height;
+        hdr.seq = seq;
+        hdr.len = frame_len;
+        hdr.crc = crc;
+        hdr.hdr_crc = hdr_crc(&hdr);
+    esp_err_t ret = esp_partition_erase_range(part, ofs, slot_size);
+    if (ret == ESP_OK)
+    {
+        ret = esp_partition_write(part, ofs + EPD_STORE_DATA_OFS, frame, frame_len);
+    }
+    if (ret == ESP_OK)
+    {
+        ret = esp_partition_write(part, ofs, &hdr, sizeof(hdr));
+    }
+    if (ret != ESP_OK)
+    {
+        stats.errors++;
+        ESP_LOGW(TAG, "Save to slot %d failed: %s", next_slot, esp_err_to_name(ret));
+        next_slot = (next_slot + 1) % slots;    //坏槽跳过
+        return false;
+    }
+
+    stats.saves++;
+    stats.seq = seq;
+    seq++;
+    next_slot = (next_slot + 1) % slots;
+    last_crc = crc;
+    have_last = true;
+    last_save_us = now;
+    return true;
+}
+
+void epaper_frame_store::get_stats(epd_store_stats_t *out) {
+    *out = stats;
+}
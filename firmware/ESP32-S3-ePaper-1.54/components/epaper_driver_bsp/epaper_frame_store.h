@@ -0,0 +1,65 @@
+#ifndef EPAPER_FRAME_STORE_H
+#define EPAPER_FRAME_STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_partition.h"
+
+#define EPD_STORE_MAGIC      0x46445045  /* "EPDF" */
+#define EPD_STORE_VERSION    1
+#define EPD_STORE_DATA_OFS   32          /* 槽内帧数据的偏移, 前面是头 */
+
+/* 每个槽的头; 先写帧数据再写头, 掉电时只会留下头无效的槽 */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t width;
+    uint16_t height;
+    uint16_t reserved;
+    uint32_t seq;           /* 递增, 最大的有效槽为最新帧 */
+    uint32_t len;
+    uint32_t crc;           /* 帧数据 */
+    uint32_t hdr_crc;       /* 以上字段 */
+}epd_store_hdr_t;
+
+typedef struct {
+    uint32_t saves;
+    uint32_t skipped_same;  /* 与上次保存的内容相同 */
+    uint32_t skipped_rate;  /* 距上次保存不足最小间隔 */
+    uint32_t errors;
+    uint32_t seq;
+}epd_store_stats_t;
+
+/*
+ * 把屏幕上最后一帧 (1bpp) 存到专用 data 分区, 开机时作为局部刷新的参考写回控制器, 不必整屏清白.
+ * 分区按扇区对齐切成若干槽轮流写, 每次只擦写一个槽; 再加上最小保存间隔, 控制擦写次数.
+ */
+class epaper_frame_store {
+private:
+    const esp_partition_t *part = NULL;
+    const int width;
+    const int height;
+    const int frame_len;
+    const uint32_t min_interval_s;
+    uint32_t slot_size = 0;
+    int slots = 0;
+    int next_slot = 0;
+    uint32_t seq = 1;
+    uint32_t last_crc = 0;
+    bool have_last = false;
+    int64_t last_save_us = 0;
+    epd_store_stats_t stats = {};
+
+    bool read_hdr(int slot, epd_store_hdr_t *hdr);
+    void scan();
+
+public:
+    epaper_frame_store(const char *label, int width, int height, int frame_len, uint32_t min_interval_s);
+
+    bool ready();                                   /* 分区存在且至少能放两个槽 */
+    bool load(uint8_t *frame);                      /* 读出最新的有效帧 */
+    bool save(const uint8_t *frame, bool force);    /* force 忽略最小间隔; 内容未变时不写 */
+    void get_stats(epd_store_stats_t *out);
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include <string.h>
+#include "epaper_glyph.h"
+
+void epd_glyph_set_init(epd_glyph_set_t *set, int line_height, int base_line) {
+    memset(set, 0, sizeof(*set));
+    set->line_height = line_height;
+    set->base_line = base_line;
+}
+
+bool epd_glyph_add(epd_glyph_set_t *set, uint32_t letter, int box_w, int box_h, int ofs_x, int ofs_y, int adv_w,
+                   const uint8_t *src, int bpp) {
+    const int stride = (box_w + 7) >> 3;
+    if (set->count >= EPD_GLYPH_MAX || box_w > EPD_GLYPH_MAX_W || set->pool_used + stride * box_h > EPD_GLYPH_POOL)
+    {
+        return false;
+    }
+    epd_glyph_t *g = &set->glyphs[set->count];
+    g->letter = letter;
+    g->box_w = box_w;
+    g->box_h = box_h;
+    g->ofs_x = ofs_x;
+    g->ofs_y = ofs_y;
+    g->adv_w = adv_w;
+    g->bitmap_ofs = set->pool_used;
+
+    uint8_t *dst = set->pool + set->pool_used;
+    memset(dst, 0, stride * box_h);
+    const int mask = (1 << bpp) - 1;
+    const int half = (mask + 1) >> 1;
+    uint32_t bit = 0;
+    for (int y = 0; y < box_h; y++)
+    {
+        for (int x = 0; x < box_w; x++, bit += bpp)
+        {
+            const int a = (src[bit >> 3] >> (8 - bpp - (bit & 0x07))) & mask;
+            if (a >= half)
+            {
+                dst[y * stride + (x >> 3)] |= 0x80 >> (x & 0x07);
+            }
+        }
+    }
+    set->pool_used += stride * box_h;
+    set->count++;
+    return true;
+}
+
+const epd_glyph_t *epd_glyph_find(const epd_glyph_set_t *set, uint32_t letter) {
+    for (int i = 0; i < set->count; i++)
+    {
+        if (set->glyphs[i].letter == letter)
+        {
+            return &set->glyphs[i];
+        }
+    }
+    return NULL;
+}
+
+int epd_text_width(const epd_glyph_set_t *set, const char *text) {
+    int w = 0;
+    for (; *text; text++)
+    {
+        const epd_glyph_t *g = epd_glyph_find(set, (uint8_t)*text);
+        if (g)
+        {
+            w += g->adv_w;
+        }
+    }
+    return w;
+}
+
+/* 一行字形位图 (高位在左, 最多 EPD_GLYPH_MAX_W 位, 1 为黑) 在 px 处与进帧缓冲 (&= ~b, 帧缓冲 1 为白), 只改 [bx1, bx2] 内的字节 */
+static inline void draw_row(uint8_t *row, int bx1, int bx2, int px, uint32_t bits) {
+    if (bits == 0)
+    {
+        return;
+    }
+    int bx = px >> 3;
+    bits >>= (px & 0x07);
+    for (int k = 0; k < 4 && bits; k++, bx++, bits <<= 8)
+    {
+        const uint8_t b = bits >> 24;
+        if (b && bx >= bx1 && bx <= bx2)
+        {
+            row[bx] &= ~b;
+        }
+    }
+}
+
+void epd_text_draw(const epd_glyph_set_t *set, uint8_t *fb, int stride, const epd_window_t *clip,
+                   int x, int y, const char *text) {
+    const int bx1 = clip->x1 >> 3;
+    const int bx2 = clip->x2 >> 3;
+    for (int cy = clip->y1; cy <= clip->y2; cy++)
+    {
+        memset(fb + cy * stride + bx1, 0xff, bx2 - bx1 + 1);
+    }
+
+    const int baseline = y + set->line_height - set->base_line;
+    for (; *text; text++)
+    {
+        const epd_glyph_t *g = epd_glyph_find(set, (uint8_t)*text);
+        if (g == NULL)
+        {
+            continue;
+        }
+        const int gx = x + g->ofs_x;
+        const int gy = baseline - g->box_h - g->ofs_y;
+        const int gstride = (g->box_w + 7) >> 3;
+        const uint8_t *src = set->pool + g->bitmap_ofs;
+        for (int r = 0; r < g->box_h; r++, src += gstride)
+        {
+            const int py = gy + r;
+            if (py < clip->y1 || py > clip->y2 || gx < 0)
+            {
+                continue;
+            }
+            uint32_t bits = 0;
+            for (int i = 0; i < gstride; i++)
+            {
+                bits |= (uint32_t)src[i] << (24 - 8 * i);
+            }
+            draw_row(fb + py * stride, bx1, bx2, gx, bits);
+        }
+        x += g->adv_w;
+    }
+}
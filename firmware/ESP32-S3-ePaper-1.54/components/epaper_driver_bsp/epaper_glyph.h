@@ -0,0 +1,52 @@
+#ifndef EPAPER_GLYPH_H
+#define EPAPER_GLYPH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "epaper_frame_diff.h"
+
+#define EPD_GLYPH_MAX       16      /* 一组字形的最大字符数 */
+#define EPD_GLYPH_MAX_W     24      /* 单个字形的最大宽度, 一行位图放进 32 位 */
+#define EPD_GLYPH_POOL      1024    /* 位图总字节数 */
+
+/* 字形度量与 LVGL 一致: ofs_y 为字形框底边到基线的距离 */
+typedef struct {
+    uint32_t letter;
+    uint8_t box_w;
+    uint8_t box_h;
+    int8_t ofs_x;
+    int8_t ofs_y;
+    uint8_t adv_w;
+    uint16_t bitmap_ofs;    /* 1bpp, 每行 (box_w+7)/8 字节, 1 为黑 */
+}epd_glyph_t;
+
+/* 预先二值化好的一小组字形 (时钟用到的数字和分隔符), 绘制时不经过 LVGL */
+typedef struct {
+    int line_height;
+    int base_line;          /* 基线到行底的距离 */
+    int count;
+    int pool_used;
+    epd_glyph_t glyphs[EPD_GLYPH_MAX];
+    uint8_t pool[EPD_GLYPH_POOL];
+}epd_glyph_set_t;
+
+void epd_glyph_set_init(epd_glyph_set_t *set, int line_height, int base_line);
+
+/* src 为逐像素连续排列的 bpp 位 alpha 位图 (LVGL 未压缩格式), 不透明度过半记为黑, 与 set_px_cb 的取舍一致 */
+bool epd_glyph_add(epd_glyph_set_t *set, uint32_t letter, int box_w, int box_h, int ofs_x, int ofs_y, int adv_w,
+                   const uint8_t *src, int bpp);
+
+const epd_glyph_t *epd_glyph_find(const epd_glyph_set_t *set, uint32_t letter);
+
+/* ASCII 文本宽度, 缺字的字符跳过 */
+int epd_text_width(const epd_glyph_set_t *set, const char *text);
+
+/*
+ * 在 1bpp 缓冲 fb (每行 stride 字节, 1 为白) 中把 clip 填白 (全置 1), 再以 (x, y) 为行左上角画 text:
+ * 字形位图中为 1 (黑) 的位与进帧缓冲 (fb &= ~glyph), 只会把白清成黑.
+ * clip 的 X 需按字节对齐 (x1 为 8 的倍数, x2 为 8 的倍数减 1), 超出 clip 的像素不画.
+ */
+void epd_text_draw(const epd_glyph_set_t *set, uint8_t *fb, int stride, const epd_window_t *clip,
+                   int x, int y, const char *text);
+
+#endif
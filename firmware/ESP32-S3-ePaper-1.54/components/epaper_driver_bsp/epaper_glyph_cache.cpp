@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <string.h>
+#include "epaper_glyph_cache.h"
+#include "esp_log.h"
+
+static const char *TAG = "epd_glyph";
+
+#define SLOT_NONE   0xffff
+
+epaper_glyph_cache::epaper_glyph_cache(int _capacity) :
+    capacity(_capacity < SLOT_NONE ? _capacity : SLOT_NONE - 1),
+    head(SLOT_NONE),
+    tail(SLOT_NONE) {
+
+    uint32_t nbuckets = 1;
+    while (nbuckets < (uint32_t)capacity)
+    {
+        nbuckets <<= 1;
+    }
+    slots = (epd_glyph_slot_t *)calloc(capacity, sizeof(epd_glyph_slot_t));
+    buckets = (uint16_t *)malloc(nbuckets * sizeof(uint16_t));
+    if (slots == NULL || buckets == NULL)
+    {
+        ESP_LOGW(TAG, "No memory for %d glyph slots, cache disabled", capacity);
+        free(slots);
+        free(buckets);
+        slots = NULL;
+        buckets = NULL;
+        return;
+    }
+    memset(buckets, 0xff, nbuckets * sizeof(uint16_t));
+    bucket_mask = nbuckets - 1;
+}
+
+epaper_glyph_cache::~epaper_glyph_cache() {
+    free(slots);
+    free(buckets);
+}
+
+bool epaper_glyph_cache::ready() {
+    return slots != NULL;
+}
+
+uint16_t *epaper_glyph_cache::bucket_of(uint32_t letter) {
+    /* 常用汉字码位连续, 乘法散列把相邻码位打散到不同的桶 */
+    return &buckets[(letter * 2654435761u) >> 16 & bucket_mask];
+}
+
+epd_glyph_slot_t *epaper_glyph_cache::lookup(uint32_t letter) {
+    if (slots == NULL)
+    {
+        return NULL;
+    }
+    for (uint16_t i = *bucket_of(letter); i != SLOT_NONE; i = slots[i].hnext)
+    {
+        if (slots[i].letter == letter)
+        {
+            return &slots[i];
+        }
+    }
+    return NULL;
+}
+
+void epaper_glyph_cache::lru_unlink(uint16_t idx) {
+    epd_glyph_slot_t *s = &slots[idx];
+    if (s->prev != SLOT_NONE)
+    {
+        slots[s->prev].next = s->next;
+    }
+    else
+    {
+        head = s->next;
+    }
+    if (s->next != SLOT_NONE)
+    {
+        slots[s->next].prev = s->prev;
+    }
+    else
+    {
+        tail = s->prev;
+    }
+}
+
+void epaper_glyph_cache::lru_push_front(uint16_t idx) {
+    slots[idx].prev = SLOT_NONE;
+    slots[idx].next = head;
+    if (head != SLOT_NONE)
+    {
+        slots[head].prev = idx;
+    }
+    head = idx;
+    if (tail == SLOT_NONE)
+    {
+        tail = idx;
+    }
+}
+
+void epaper_glyph_cache::hash_remove(uint16_t idx) {
+    uint16_t *p = bucket_of(slots[idx].letter);
+    while (*p != SLOT_NONE && *p != idx)
+    {
+        p = &slots[*p].hnext;
+    }
+    if (*p == idx)
+    {
+        *p = slots[idx].hnext;
+    }
+}
+
+const epd_glyph_slot_t *epaper_glyph_cache::find(uint32_t letter) {
+    epd_glyph_slot_t *s = lookup(letter);
+    if (s == NULL)
+    {
+        stats.misses++;
+        return NULL;
+    }
+    stats.hits++;
+    const uint16_t idx = s - slots;
+    if (idx != head)
+    {
+        lru_unlink(idx);
+        lru_push_front(idx);
+    }
+    return s;
+}
+
+const epd_glyph_slot_t *epaper_glyph_cache::peek(uint32_t letter) {
+    return lookup(letter);
+}
+
+const epd_glyph_slot_t *epaper_glyph_cache::insert(uint32_t letter, const epd_glyph_metrics_t *m, const uint8_t *src, int bpp) {
+    if (slots == NULL)
+    {
+        return NULL;
+    }
+    const uint32_t px = (uint32_t)m->box_w * m->box_h;
+    if (px > EPD_GLYPH_SLOT_BYTES * 8 || (px && src == NULL))
+    {
+        stats.oversize++;
+        return NULL;
+    }
+
+    epd_glyph_slot_t *s = lookup(letter);
+    uint16_t idx;
+    if (s != NULL)
+    {
+        /* 已缓存: 原地覆盖 */
+        idx = s - slots;
+        lru_unlink(idx);
+    }
+    else
+    {
+        if (used < capacity)
+        {
+            idx = used++;
+        }
+        else
+        {
+            idx = tail;
+            lru_unlink(idx);
+            hash_remove(idx);
+            stats.evictions++;
+        }
+        s = &slots[idx];
+        uint16_t *b = bucket_of(letter);
+        s->hnext = *b;
+        *b = idx;
+    }
+    s->letter = letter;
+    s->m = *m;
+
+    /* 连续位流按像素二值化, 输出同样不按行补齐 */
+    memset(s->bitmap, 0, sizeof(s->bitmap));
+    const int mask = (1 << bpp) - 1;
+    const int half = (mask + 1) >> 1;
+    uint32_t bit = 0;
+    for (uint32_t i = 0; i < px; i++, bit += bpp)
+    {
+        const int a = (src[bit >> 3] >> (8 - bpp - (bit & 0x07))) & mask;
+        if (a >= half)
+        {
+            s->bitmap[i >> 3] |= 0x80 >> (i & 0x07);
+        }
+    }
+    lru_push_front(idx);
+    return s;
+}
+
+void epaper_glyph_cache::get_stats(epd_glyph_cache_stats_t *out) {
+    *out = stats;
+    out->used = used;
+}
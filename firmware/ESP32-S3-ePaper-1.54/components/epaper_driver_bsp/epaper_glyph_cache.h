@@ -0,0 +1,70 @@
+#ifndef EPAPER_GLYPH_CACHE_H
+#define EPAPER_GLYPH_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EPD_GLYPH_SLOT_BYTES  48    /* 每个槽的位图字节数, 最多 384 像素 (16 号中文约 16x17), 更大的字形不缓存 */
+
+/* 字形度量与 LVGL 的 lv_font_glyph_dsc_t 一致 */
+typedef struct {
+    uint16_t adv_w;
+    uint16_t box_w;
+    uint16_t box_h;
+    int16_t ofs_x;
+    int16_t ofs_y;
+}epd_glyph_metrics_t;
+
+typedef struct {
+    uint32_t letter;
+    epd_glyph_metrics_t m;
+    uint16_t prev;          /* LRU 链表, 头部为最近使用 */
+    uint16_t next;
+    uint16_t hnext;         /* 同一哈希桶的下一个槽 */
+    uint8_t bitmap[EPD_GLYPH_SLOT_BYTES];   /* 1bpp, 逐像素连续排列 (LVGL 未压缩格式), 1 为黑 */
+}epd_glyph_slot_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;        /* 需要从原字体取位图并二值化 */
+    uint32_t evictions;
+    uint32_t oversize;      /* 位图超出槽位, 没有缓存 */
+    uint32_t used;          /* 当前占用的槽数 */
+}epd_glyph_cache_stats_t;
+
+/*
+ * 按码位缓存预先二值化的 1bpp 字形, 槽满时淘汰最久未用的.
+ * 不依赖 LVGL: 调用方在未命中时从原字体取出度量和 alpha 位图交给 insert().
+ */
+class epaper_glyph_cache {
+private:
+    epd_glyph_slot_t *slots = NULL;
+    uint16_t *buckets = NULL;
+    const int capacity;
+    uint32_t bucket_mask = 0;
+    int used = 0;
+    uint16_t head;
+    uint16_t tail;
+    epd_glyph_cache_stats_t stats = {};
+
+    uint16_t *bucket_of(uint32_t letter);
+    epd_glyph_slot_t *lookup(uint32_t letter);
+    void lru_unlink(uint16_t idx);
+    void lru_push_front(uint16_t idx);
+    void hash_remove(uint16_t idx);
+
+public:
+    epaper_glyph_cache(int capacity);
+    ~epaper_glyph_cache();
+
+    bool ready();
+    const epd_glyph_slot_t *find(uint32_t letter);      /* 命中时移到 LRU 头部, 计入命中/未命中 */
+    const epd_glyph_slot_t *peek(uint32_t letter);      /* 不改变 LRU 顺序和统计 */
+
+    /* src 为逐像素连续排列的 bpp 位 alpha 位图, 不透明度过半记为黑, 与 set_px_cb 的取舍一致; 超出槽位时返回 NULL */
+    const epd_glyph_slot_t *insert(uint32_t letter, const epd_glyph_metrics_t *m, const uint8_t *src, int bpp);
+    void get_stats(epd_glyph_cache_stats_t *out);
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include "epaper_pack.h"
+
+typedef uint32_t __attribute__((__may_alias__)) pack_word_t;
+
+const uint16_t epd_luma_r[32] = {
+    0, 2, 5, 8, 13, 19, 27, 36, 47, 60, 74, 90, 108, 128, 150, 174,
+    200, 228, 258, 291, 325, 363, 402, 444, 488, 535, 585, 637, 691, 748, 808, 871,
+};
+
+const uint16_t epd_luma_g[64] = {
+    0, 4, 7, 11, 15, 21, 27, 35, 43, 53, 63, 75, 88, 103, 118, 135,
+    154, 173, 194, 217, 241, 266, 293, 321, 351, 383, 416, 450, 487, 525, 564, 606,
+    649, 693, 740, 788, 838, 890, 944, 999, 1057, 1116, 1177, 1240, 1305, 1372, 1441, 1512,
+    1585, 1660, 1737, 1816, 1897, 1980, 2066, 2153, 2242, 2334, 2428, 2523, 2621, 2722, 2824, 2929,
+};
+
+const uint16_t epd_luma_b[32] = {
+    0, 1, 2, 3, 4, 7, 9, 12, 16, 20, 25, 31, 37, 43, 51, 59,
+    68, 77, 88, 99, 111, 123, 137, 151, 166, 182, 199, 216, 235, 254, 274, 296,
+};
+
+/* (2t+1)/32 满量程, t 为标准 4x4 Bayer 矩阵 */
+const uint16_t epd_bayer4[4][4] = {
+    {128, 2176, 640, 2688},
+    {3200, 1152, 3712, 1664},
+    {896, 2944, 384, 2432},
+    {3968, 1920, 3456, 1408},
+};
+
+/*
+ * 一个 32bit 字装两个像素 (低半字在左). p >= 0x7fff 等价于 bit15 为 1 或低 15 位全 1,
+ * 低 15 位加 1 后进位到 bit15 正好覆盖后一种情况, 且每个半字最多到 0x8000, 不会串到相邻像素.
+ * 返回值 bit1 为左像素, bit0 为右像素.
+ */
+static inline uint32_t pack_pair(uint32_t w) {
+    const uint32_t m = (w & 0x7fff7fff) + 0x00010001;
+    const uint32_t r = w | m;
+    return ((r >> 14) & 0x02) | (r >> 31);
+}
+
+/* 8 个像素 -> 1 字节, src 4 字节对齐时每次读两个像素, 减少对 PSRAM 的访问次数 */
+static inline uint8_t pack_byte_aligned(const pack_word_t *w) {
+    return (uint8_t)((pack_pair(w[0]) << 6) | (pack_pair(w[1]) << 4) | (pack_pair(w[2]) << 2) | pack_pair(w[3]));
+}
+
+static inline uint8_t pack_byte(const uint16_t *src) {
+    uint8_t b = 0;
+    for (int k = 0; k < 8; k++)
+    {
+        b = (b << 1) | (src[k] >= EPD_PACK_THRESHOLD);
+    }
+    return b;
+}
+
+/* 旧的红色最高位阈值, 保持与逐像素路径逐位一致 */
+static void pack_row_legacy(const uint16_t *src, uint8_t *dst, int bytes) {
+    int i = 0;
+    if (((uintptr_t)src & 0x03) == 0)
+    {
+        const pack_word_t *w = (const pack_word_t *)src;
+        for (; i + 1 < bytes; i += 2, w += 8)
+        {
+            dst[i] = pack_byte_aligned(w);
+            dst[i + 1] = pack_byte_aligned(w + 4);
+        }
+        for (; i < bytes; i++, w += 4)
+        {
+            dst[i] = pack_byte_aligned(w);
+        }
+    }
+    else
+    {
+        for (; i < bytes; i++)
+        {
+            dst[i] = pack_byte(src + (i << 3));
+        }
+    }
+}
+
+/* 亮度与每列阈值比较, 硬阈值和抖动只是阈值表不同; 行从 8 对齐处开始, 所以每字节的阈值相同 */
+static void pack_row_luma(const uint16_t *src, uint8_t *dst, int bytes, const uint16_t *th) {
+    for (int i = 0; i < bytes; i++, src += 8)
+    {
+        uint8_t b = 0;
+        for (int k = 0; k < 8; k++)
+        {
+            b = (b << 1) | (epd_pack_luma(src[k]) > th[k]);
+        }
+        dst[i] = b;
+    }
+}
+
+void epd_pack_rgb565_row(const uint16_t *src, uint8_t *dst, int n, int y, epd_pack_mode_t mode) {
+    const int bytes = n >> 3;
+    uint16_t th[8];
+    if (mode == EPD_PACK_LEGACY)
+    {
+        pack_row_legacy(src, dst, bytes);
+    }
+    else
+    {
+        for (int k = 0; k < 8; k++)
+        {
+            th[k] = (mode == EPD_PACK_DITHER) ? epd_bayer4[y & 3][k & 3] : EPD_PACK_LUMA_MID;
+        }
+        pack_row_luma(src, dst, bytes, th);
+    }
+
+    const int tail = n & 0x07;
+    if (tail)
+    {
+        const uint16_t *s = src + (bytes << 3);
+        uint8_t b = 0;
+        for (int k = 0; k < tail; k++)
+        {
+            b |= epd_pack_is_white(s[k], k, y, mode) << (7 - k);
+        }
+        const uint8_t mask = (uint8_t)(0xff00 >> tail);
+        dst[bytes] = (dst[bytes] & ~mask) | b;
+    }
+}
+
+void epd_pack_rgb565_rect(const uint16_t *src, uint8_t *fb, int fb_stride,
+                          int x1, int y1, int x2, int y2, epd_pack_mode_t mode) {
+    const int w = x2 - x1 + 1;
+    uint8_t *row = fb + y1 * fb_stride + (x1 >> 3);
+    for (int y = y1; y <= y2; y++)
+    {
+        epd_pack_rgb565_row(src, row, w, y, mode);
+        src += w;
+        row += fb_stride;
+    }
+}
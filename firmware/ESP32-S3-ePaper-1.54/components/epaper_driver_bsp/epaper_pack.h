@@ -0,0 +1,69 @@
+#ifndef EPAPER_PACK_H
+#define EPAPER_PACK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* RGB565 像素 >= 该值为白, 否则为黑 (与原逐像素路径一致) */
+#define EPD_PACK_THRESHOLD  0x7fff
+/* 线性亮度满量程 4095, 亮度高于 L*=50 对应的值为白 */
+#define EPD_PACK_LUMA_MID   754
+
+/* 二值化方式 */
+typedef enum {
+    EPD_PACK_LEGACY = 0,    /* 直接比较 RGB565 原值, 实际只看红色最高位 */
+    EPD_PACK_LUMA,          /* 线性亮度硬阈值, 适合文字和线条 */
+    EPD_PACK_DITHER,        /* 线性亮度 4x4 Bayer 有序抖动, 适合图片 */
+}epd_pack_mode_t;
+
+/* 各通道的线性亮度贡献 (sRGB 反伽马后乘 Rec.709 权重), 三项相加即亮度 */
+extern const uint16_t epd_luma_r[32];
+extern const uint16_t epd_luma_g[64];
+extern const uint16_t epd_luma_b[32];
+extern const uint16_t epd_bayer4[4][4];
+
+static inline uint32_t epd_pack_luma(uint16_t c) {
+    return epd_luma_r[c >> 11] + epd_luma_g[(c >> 5) & 0x3f] + epd_luma_b[c & 0x1f];
+}
+
+/* 单个像素 (x, y 为屏幕坐标) 是否为白 */
+static inline bool epd_pack_is_white(uint16_t c, int x, int y, epd_pack_mode_t mode) {
+    switch (mode)
+    {
+    case EPD_PACK_LUMA:
+        return epd_pack_luma(c) > EPD_PACK_LUMA_MID;
+    case EPD_PACK_DITHER:
+        return epd_pack_luma(c) > epd_bayer4[y & 3][x & 3];
+    default:
+        return c >= EPD_PACK_THRESHOLD;
+    }
+}
+
+/* 在 1bpp 帧缓冲 (每行 fb_stride 字节) 上直接画一个像素, 与先写 RGB565 再打包的结果逐位相同 */
+static inline void epd_pack_set_px(uint8_t *fb, int fb_stride, int x, int y, uint16_t c, epd_pack_mode_t mode) {
+    uint8_t *p = fb + y * fb_stride + (x >> 3);
+    const uint8_t bit = 0x80 >> (x & 0x07);
+    if (epd_pack_is_white(c, x, y, mode))
+    {
+        *p |= bit;
+    }
+    else
+    {
+        *p &= ~bit;
+    }
+}
+
+/*
+ * 把第 y 行从 8 对齐位置开始的 n 个 RGB565 像素二值化为 1bpp, 写入 dst (高位在左, 1 为白).
+ * 整字节部分直接覆盖, n 不是 8 的倍数时最后一个字节只改对应的高位.
+ */
+void epd_pack_rgb565_row(const uint16_t *src, uint8_t *dst, int n, int y, epd_pack_mode_t mode);
+
+/*
+ * 把连续存放的 (x2-x1+1)*(y2-y1+1) 个 RGB565 像素打包进 1bpp 帧缓冲.
+ * x1 必须按 8 对齐, fb_stride 为帧缓冲每行字节数, 坐标由调用者保证在范围内.
+ */
+void epd_pack_rgb565_rect(const uint16_t *src, uint8_t *fb, int fb_stride,
+                          int x1, int y1, int x2, int y2, epd_pack_mode_t mode);
+
+#endif
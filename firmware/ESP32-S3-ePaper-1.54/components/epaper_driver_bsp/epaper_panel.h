@@ -0,0 +1,27 @@
+#ifndef EPAPER_PANEL_H
+#define EPAPER_PANEL_H
+
+#include <stdint.h>
+
+/*
+ * 面板参数, 作为 epaper_driver 的模板参数在编译期确定几何尺寸和与型号相关的命令参数.
+ * 帧缓冲每行 stride 字节 (高位在左, 1 为白), buffer 第 y 行写到 RAM Y 地址 height-1-y.
+ * 新增 SSD168x 面板时照此定义一个结构体并在 epaper_driver_bsp.cpp 末尾显式实例化;
+ * 波形表 (epaper_waveform) 仍按 1.54" 标定, 其他面板需要换成对应的 LUT.
+ */
+
+/* 1.54" 200x200, SSD1681 */
+struct epd_panel_1in54 {
+    static constexpr int width = 200;
+    static constexpr int height = 200;
+    static constexpr int stride = (width + 7) / 8;      /* 帧缓冲与 RAM 每行字节数 */
+    static constexpr int fb_bytes = stride * height;
+    static constexpr uint16_t gate_lines = height;      /* 0x01 的 MUX 设置为 gate_lines-1 */
+    static constexpr uint8_t scan_ctrl = 0x01;          /* 0x01 第三个参数: TB=1, 与 RAM Y 递减配合 */
+    static constexpr uint8_t entry_mode = 0x01;         /* 0x11: X 递增, Y 递减 */
+    static constexpr uint8_t border_full = 0x01;        /* 0x3C, 全刷 */
+    static constexpr uint8_t border_partial = 0x80;     /* 0x3C, 局部刷新 */
+    static constexpr uint8_t temp_sensor = 0x80;        /* 0x18: 内部温度传感器 */
+};
+
+#endif
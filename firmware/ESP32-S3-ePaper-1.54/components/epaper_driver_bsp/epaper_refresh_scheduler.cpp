@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <time.h>
+#include "epaper_refresh_scheduler.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+static const char *TAG = "epd_sched";
+
+#define SCHED_NVS_NAMESPACE "epd_sched"
+#define SCHED_SAVE_EVERY    50      /* 每累计多少次局部刷新写一次 NVS, 控制 Flash 磨损 */
+
+epaper_refresh_scheduler::epaper_refresh_scheduler(const epd_refresh_policy_t &_policy) :
+    policy(_policy) {
+    last_full_us = esp_timer_get_time();
+}
+
+epaper_refresh_scheduler::~epaper_refresh_scheduler() {
+
+}
+
+void epaper_refresh_scheduler::load() {
+    nvs_handle_t nvs;
+    if (nvs_open(SCHED_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK)
+    {
+        return;     //首次启动, 还没有记录
+    }
+    epd_panel_lifetime_t lt = {};
+    nvs_get_u64(nvs, "partial", &lt.partial_total);
+    nvs_get_u64(nvs, "full", &lt.full_total);
+    nvs_get_u64(nvs, "px", &lt.changed_px_total);
+    nvs_close(nvs);
+
+    portENTER_CRITICAL(&lock);
+    lifetime = lt;
+    portEXIT_CRITICAL(&lock);
+    ESP_LOGI(TAG, "Panel lifetime: %llu partial, %llu full refreshes",
+             (unsigned long long)lt.partial_total, (unsigned long long)lt.full_total);
+}
+
+void epaper_refresh_scheduler::save() {
+    portENTER_CRITICAL(&lock);
+    epd_panel_lifetime_t lt = lifetime;
+    unsaved = 0;
+    portEXIT_CRITICAL(&lock);
+
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(SCHED_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "nvs_open failed: %s", esp_err_to_name(ret));
+        return;
+    }
+    nvs_set_u64(nvs, "partial", lt.partial_total);
+    nvs_set_u64(nvs, "full", lt.full_total);
+    nvs_set_u64(nvs, "px", lt.changed_px_total);
+    nvs_commit(nvs);
+    nvs_close(nvs);
+}
+
+/* 任一启用的阈值达到 percent% 即返回 true, 调用者需持有 lock */
+bool epaper_refresh_scheduler::over_threshold(uint32_t percent) {
+    if (policy.max_partials && (uint64_t)partials * 100 >= (uint64_t)policy.max_partials * percent)
+    {
+        return true;
+    }
+    if (policy.max_changed_px && (uint64_t)changed_px * 100 >= (uint64_t)policy.max_changed_px * percent)
+    {
+        return true;
+    }
+    uint64_t elapsed_s = (esp_timer_get_time() - last_full_us) / 1000000;
+    if (policy.max_interval_s && elapsed_s * 100 >= (uint64_t)policy.max_interval_s * percent)
+    {
+        return true;
+    }
+    return false;
+}
+
+bool epaper_refresh_scheduler::full_due(epd_update_class_t cls) {
+    if (cls == EPD_UPDATE_URGENT_PARTIAL)
+    {
+        return false;
+    }
+    uint32_t percent = (cls == EPD_UPDATE_CAN_DEFER) ? policy.defer_percent : 100;
+    portENTER_CRITICAL(&lock);
+    bool due = over_threshold(percent);
+    portEXIT_CRITICAL(&lock);
+    return due || idle_full_due();
+}
+
+epd_waveform_id_t epaper_refresh_scheduler::pick_waveform(epd_update_class_t cls, uint32_t changed_px) {
+    if (full_due(cls))
+    {
+        return EPD_WF_FULL;
+    }
+    if (policy.fast_max_px && changed_px <= policy.fast_max_px)
+    {
+        return EPD_WF_FAST_PARTIAL;
+    }
+    return policy.partial_wf;
+}
+
+bool epaper_refresh_scheduler::idle_full_due() {
+    if (policy.quiet_hour < 0)
+    {
+        return false;
+    }
+    time_t now;
+    time(&now);
+    struct tm t_info;
+    localtime_r(&now, &t_info);
+    if (t_info.tm_year < (2020 - 1900))
+    {
+        return false;   //尚未校时
+    }
+
+    portENTER_CRITICAL(&lock);
+    bool due = t_info.tm_hour == policy.quiet_hour && t_info.tm_yday != last_full_yday && partials > 0;
+    portEXIT_CRITICAL(&lock);
+    return due;
+}
+
+void epaper_refresh_scheduler::on_partial(uint32_t px) {
+    portENTER_CRITICAL(&lock);
+    partials++;
+    changed_px += px;
+    lifetime.partial_total++;
+    lifetime.changed_px_total += px;
+    bool flush = ++unsaved >= SCHED_SAVE_EVERY;
+    portEXIT_CRITICAL(&lock);
+    if (flush)
+    {
+        save();
+    }
+}
+
+void epaper_refresh_scheduler::on_full() {
+    time_t now;
+    time(&now);
+    struct tm t_info;
+    localtime_r(&now, &t_info);
+
+    portENTER_CRITICAL(&lock);
+    partials = 0;
+    changed_px = 0;
+    last_full_us = esp_timer_get_time();
+    last_full_yday = t_info.tm_yday;
+    lifetime.full_total++;
+    portEXIT_CRITICAL(&lock);
+    save();
+}
+
+void epaper_refresh_scheduler::get_stats(epd_refresh_sched_stats_t *stats) {
+    portENTER_CRITICAL(&lock);
+    stats->partials = partials;
+    stats->changed_px = changed_px;
+    stats->seconds_since_full = (esp_timer_get_time() - last_full_us) / 1000000;
+    stats->lifetime = lifetime;
+    portEXIT_CRITICAL(&lock);
+}
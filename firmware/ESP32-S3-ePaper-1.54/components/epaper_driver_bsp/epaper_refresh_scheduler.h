@@ -0,0 +1,68 @@
+#ifndef EPAPER_REFRESH_SCHEDULER_H
+#define EPAPER_REFRESH_SCHEDULER_H
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "epaper_waveform.h"
+
+/* 更新的紧急程度, 数值越小越紧急; 合并刷新时取最紧急的一个 */
+typedef enum {
+    EPD_UPDATE_URGENT_PARTIAL = 0,  /* 必须立刻局部刷新, 即使已经该全刷也推迟 */
+    EPD_UPDATE_NORMAL,              /* 全刷到期时改为全刷 */
+    EPD_UPDATE_CAN_DEFER,           /* 不着急, 全刷接近到期时就顺便全刷 */
+}epd_update_class_t;
+
+/* 全刷策略, 任一阈值为 0 表示不启用该项 */
+typedef struct {
+    uint32_t max_partials;      /* 连续局部刷新次数 */
+    uint32_t max_changed_px;    /* 累计变化像素数 */
+    uint32_t max_interval_s;    /* 距上次全刷的秒数 */
+    int quiet_hour;             /* 每天在该小时 (本地时间) 空闲时做一次清洁全刷, -1 关闭 */
+    uint32_t defer_percent;     /* CAN_DEFER 更新在达到阈值的该百分比时即全刷 */
+    epd_waveform_id_t partial_wf;   /* 默认局部波形 */
+    uint32_t fast_max_px;       /* 变化像素不超过该值时用 EPD_WF_FAST_PARTIAL, 0 不启用 */
+}epd_refresh_policy_t;
+
+/* 屏幕寿命统计, 持久化在 NVS 中 */
+typedef struct {
+    uint64_t partial_total;
+    uint64_t full_total;
+    uint64_t changed_px_total;
+}epd_panel_lifetime_t;
+
+/* 当前全刷周期内的状态 */
+typedef struct {
+    uint32_t partials;
+    uint32_t changed_px;
+    uint32_t seconds_since_full;
+    epd_panel_lifetime_t lifetime;
+}epd_refresh_sched_stats_t;
+
+class epaper_refresh_scheduler {
+private:
+    const epd_refresh_policy_t policy;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    uint32_t partials = 0;
+    uint32_t changed_px = 0;
+    int64_t last_full_us = 0;
+    int last_full_yday = -1;
+    uint32_t unsaved = 0;
+    epd_panel_lifetime_t lifetime = {};
+
+    bool over_threshold(uint32_t percent);
+    void save();
+
+public:
+    epaper_refresh_scheduler(const epd_refresh_policy_t &_policy);
+    ~epaper_refresh_scheduler();
+
+    void load();                                    /* 从 NVS 读取寿命统计 */
+    bool full_due(epd_update_class_t cls);          /* 本次更新是否应改为全刷 */
+    epd_waveform_id_t pick_waveform(epd_update_class_t cls, uint32_t changed_px); /* 全刷到期时返回 EPD_WF_FULL */
+    bool idle_full_due();                           /* 空闲时是否应主动全刷 (安静时段) */
+    void on_partial(uint32_t px);
+    void on_full();
+    void get_stats(epd_refresh_sched_stats_t *stats);
+};
+
+#endif
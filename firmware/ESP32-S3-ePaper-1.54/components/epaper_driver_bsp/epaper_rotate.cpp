@@ -0,0 +1,146 @@
+#include <string.h>
+#include "epaper_rotate.h"
+
+void epd_orient_init(epd_orient_t *o, int pw, int ph, epd_rotation_t rot, bool mirror) {
+    o->rot = rot;
+    o->mirror = mirror;
+    switch (rot)
+    {
+    case EPD_ROT_90:    //逻辑左上角在面板右上角
+        o->swap = true;
+        o->flip_x = true;
+        o->flip_y = mirror;
+        break;
+    case EPD_ROT_180:
+        o->swap = false;
+        o->flip_x = !mirror;
+        o->flip_y = true;
+        break;
+    case EPD_ROT_270:
+        o->swap = true;
+        o->flip_x = false;
+        o->flip_y = !mirror;
+        break;
+    default:
+        o->swap = false;
+        o->flip_x = mirror;
+        o->flip_y = false;
+        break;
+    }
+    o->pw = pw;
+    o->ph = ph;
+    o->lw = o->swap ? ph : pw;
+    o->lh = o->swap ? pw : ph;
+    o->lstride = (o->lw + 7) >> 3;
+    o->pstride = (pw + 7) >> 3;
+}
+
+void epd_orient_map_window(const epd_orient_t *o, const epd_window_t *logical, epd_window_t *panel) {
+    int ax, ay, bx, by;
+    epd_orient_map(o, logical->x1, logical->y1, &ax, &ay);
+    epd_orient_map(o, logical->x2, logical->y2, &bx, &by);
+    panel->x1 = ax < bx ? ax : bx;
+    panel->x2 = ax < bx ? bx : ax;
+    panel->y1 = ay < by ? ay : by;
+    panel->y2 = ay < by ? by : ay;
+}
+
+static inline uint8_t rev8(uint8_t b) {
+    b = (b >> 4) | (b << 4);
+    b = ((b & 0xcc) >> 2) | ((b & 0x33) << 2);
+    return ((b & 0xaa) >> 1) | ((b & 0x55) << 1);
+}
+
+/*
+ * 8x8 位矩阵转置 (Hacker's Delight 7-3, 只用 32 位运算): 输入第 r 字节为第 r 行 (高位在左),
+ * 输出第 k 字节为原第 k 列, 高位为原第 0 行.
+ */
+static inline void transpose8(const uint8_t *in, int in_step, uint8_t *out) {
+    uint32_t x = ((uint32_t)in[0] << 24) | ((uint32_t)in[in_step] << 16) | ((uint32_t)in[2 * in_step] << 8) | in[3 * in_step];
+    uint32_t y = ((uint32_t)in[4 * in_step] << 24) | ((uint32_t)in[5 * in_step] << 16) | ((uint32_t)in[6 * in_step] << 8) | in[7 * in_step];
+    uint32_t t;
+    t = (x ^ (x >> 7)) & 0x00aa00aa;  x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00aa00aa;  y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc; x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000cccc; y = y ^ t ^ (t << 14);
+    t = (x & 0xf0f0f0f0) | ((y >> 4) & 0x0f0f0f0f);
+    y = ((x << 4) & 0xf0f0f0f0) | (y & 0x0f0f0f0f);
+    x = t;
+    out[0] = x >> 24; out[1] = x >> 16; out[2] = x >> 8; out[3] = x;
+    out[4] = y >> 24; out[5] = y >> 16; out[6] = y >> 8; out[7] = y;
+}
+
+/* 不旋转 (可能翻转): 逐行整字节搬运, 面板 x 反向时字节倒序且位翻转 */
+static void blit_rows(const epd_orient_t *o, const uint8_t *lbuf, uint8_t *fb, int bx1, int bx2, int ly1, int ly2) {
+    const int n = bx2 - bx1 + 1;
+    for (int ly = ly1; ly <= ly2; ly++)
+    {
+        const uint8_t *s = lbuf + ly * o->lstride + bx1;
+        const int py = o->flip_y ? o->ph - 1 - ly : ly;
+        uint8_t *d = fb + py * o->pstride;
+        if (!o->flip_x)
+        {
+            memcpy(d + bx1, s, n);
+            continue;
+        }
+        d += o->pstride - 1 - bx1;
+        for (int i = 0; i < n; i++)
+        {
+            *d-- = rev8(s[i]);
+        }
+    }
+}
+
+/* 旋转 90/270: 每个 8x8 块转置一次, 逻辑的 8 列变成面板的 8 行 */
+static void blit_tiles(const epd_orient_t *o, const uint8_t *lbuf, uint8_t *fb, int bx1, int bx2, int by1, int by2) {
+    uint8_t t[8];
+    for (int by = by1; by <= by2; by++)
+    {
+        const uint8_t *row = lbuf + (by << 3) * o->lstride;
+        const int pbx = o->flip_x ? o->pstride - 1 - by : by;
+        for (int bx = bx1; bx <= bx2; bx++)
+        {
+            transpose8(row + bx, o->lstride, t);
+            for (int k = 0; k < 8; k++)
+            {
+                const int lx = (bx << 3) + k;
+                const int py = o->flip_y ? o->ph - 1 - lx : lx;
+                fb[py * o->pstride + pbx] = o->flip_x ? rev8(t[k]) : t[k];
+            }
+        }
+    }
+}
+
+void epd_rotate_blit(const epd_orient_t *o, const uint8_t *lbuf, uint8_t *fb, int lx1, int ly1, int lx2, int ly2) {
+    if (((o->pw | o->ph) & 0x07) == 0)
+    {
+        if (o->swap)
+        {
+            blit_tiles(o, lbuf, fb, lx1 >> 3, lx2 >> 3, ly1 >> 3, ly2 >> 3);
+        }
+        else
+        {
+            blit_rows(o, lbuf, fb, lx1 >> 3, lx2 >> 3, ly1, ly2);
+        }
+        return;
+    }
+
+    for (int ly = ly1; ly <= ly2; ly++)
+    {
+        for (int lx = lx1; lx <= lx2; lx++)
+        {
+            int px, py;
+            epd_orient_map(o, lx, ly, &px, &py);
+            const uint8_t bit = 0x80 >> (px & 0x07);
+            uint8_t *d = fb + py * o->pstride + (px >> 3);
+            if ((lbuf[ly * o->lstride + (lx >> 3)] << (lx & 0x07)) & 0x80)
+            {
+                *d |= bit;
+            }
+            else
+            {
+                *d &= ~bit;
+            }
+        }
+    }
+}
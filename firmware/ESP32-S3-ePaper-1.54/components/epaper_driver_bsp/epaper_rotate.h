@@ -0,0 +1,55 @@
+#ifndef EPAPER_ROTATE_H
+#define EPAPER_ROTATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "epaper_frame_diff.h"
+
+/* 面板安装方向, 顺时针 */
+typedef enum {
+    EPD_ROT_0 = 0,
+    EPD_ROT_90,
+    EPD_ROT_180,
+    EPD_ROT_270,
+}epd_rotation_t;
+
+/*
+ * 逻辑坐标 (LVGL 看到的画面) 到面板坐标的映射. mirror 先在逻辑画面内左右翻转, 再旋转.
+ * 旋转 90/270 时逻辑宽高与面板宽高互换.
+ */
+typedef struct {
+    epd_rotation_t rot;
+    bool mirror;
+    bool swap;          /* 逻辑 x 对应面板 y */
+    bool flip_x;        /* 面板 x 反向 */
+    bool flip_y;        /* 面板 y 反向 */
+    int lw, lh;         /* 逻辑宽高 */
+    int pw, ph;         /* 面板宽高 */
+    int lstride;        /* 逻辑 1bpp 缓冲每行字节数 */
+    int pstride;
+}epd_orient_t;
+
+void epd_orient_init(epd_orient_t *o, int pw, int ph, epd_rotation_t rot, bool mirror);
+
+static inline bool epd_orient_identity(const epd_orient_t *o) {
+    return !o->swap && !o->flip_x && !o->flip_y;
+}
+
+static inline void epd_orient_map(const epd_orient_t *o, int lx, int ly, int *px, int *py) {
+    int x = o->swap ? ly : lx;
+    int y = o->swap ? lx : ly;
+    *px = o->flip_x ? o->pw - 1 - x : x;
+    *py = o->flip_y ? o->ph - 1 - y : y;
+}
+
+/* 把逻辑矩形映射为面板矩形 (两端点排序后) */
+void epd_orient_map_window(const epd_orient_t *o, const epd_window_t *logical, epd_window_t *panel);
+
+/*
+ * 把逻辑 1bpp 缓冲 lbuf 中的矩形按 o 转写到面板帧缓冲 fb (都是高位在左, 1 为白).
+ * 面板宽高都是 8 的倍数时以 8x8 块为单位做位矩阵转置/字节翻转, 矩形向外扩到 8x8 块边界 (lbuf 是完整的逻辑画面, 扩出的部分内容同样正确);
+ * 否则逐像素搬运.
+ */
+void epd_rotate_blit(const epd_orient_t *o, const uint8_t *lbuf, uint8_t *fb, int lx1, int ly1, int lx2, int ly2);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef EPAPER_TRANSPORT_H
+#define EPAPER_TRANSPORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct {
+    uint8_t cs;
+    uint8_t dc;
+    uint8_t rst;
+    uint8_t busy;
+    uint8_t mosi;
+    uint8_t scl;
+    int spi_host;
+}custom_lcd_spi_t;
+
+typedef void (*epd_spi_done_cb_t)(void *arg);
+
+/* SPI 传输统计 */
+typedef struct {
+    uint32_t bytes;
+    uint32_t transactions;
+}epd_spi_stats_t;
+
+/*
+ * 驱动与控制器之间的最小接口: 带 DC 电平的字节流, RST, BUSY 和一次寄存器读.
+ * 板上实现见 epaper_transport_spi, 主机上可换成 epaper_emulator 离线验证刷新流程.
+ * 除 fence 的回调外, 所有方法只在持有驱动 bus_mux 的任务中调用.
+ */
+class epaper_transport {
+public:
+    virtual ~epaper_transport() {}
+
+    /* 排队发送一段命令 (dc_level 0) 或数据 (1); len > 4 时 data 在传输完成前必须保持有效 */
+    virtual void queue(uint8_t dc_level, const uint8_t *data, int len) = 0;
+    /* 返回代表已排队传输的票据; cb 不为空时在这些传输完成后调用 (可能在中断上下文) */
+    virtual uint32_t fence(epd_spi_done_cb_t cb, void *arg) = 0;
+    virtual void wait(uint32_t ticket) = 0;
+    virtual void set_rst(int level) = 0;
+    /* 等已排队的传输发完, 再等 BUSY 变低 */
+    virtual void wait_busy() = 0;
+    /* 发送命令 cmd 后读回 len 字节, 调用前队列需已清空 */
+    virtual bool read(uint8_t cmd, uint8_t *data, int len) = 0;
+    virtual void delay_ms(uint32_t ms) = 0;
+    virtual void get_stats(epd_spi_stats_t *stats) = 0;
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "epaper_transport_spi.h"
+#include "esp_log.h"
+
+static const char *TAG = "epd_spi";
+
+epaper_transport_spi::epaper_transport_spi(custom_lcd_spi_t _lcd_spi_data, int max_transfer_sz) :
+    lcd_spi_data(_lcd_spi_data) {
+
+    busy_sem = xSemaphoreCreateBinary();
+    assert(busy_sem);
+#if CONFIG_PM_ENABLE
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "epd_busy", &pm_lock));
+#endif
+
+    ESP_LOGI(TAG, "Initialize SPI");
+    spi_port_init(max_transfer_sz);
+    spi_gpio_init();
+}
+
+void epaper_transport_spi::spi_gpio_init() {
+    int rst = lcd_spi_data.rst;
+    int dc = lcd_spi_data.dc;
+    int busy = lcd_spi_data.busy;
+
+    gpio_config_t gpio_conf = {};
+	gpio_conf.intr_type = GPIO_INTR_DISABLE;
+	gpio_conf.mode = GPIO_MODE_OUTPUT;
+	gpio_conf.pin_bit_mask = (0x1ULL<<rst) | (0x1ULL<<dc);   //CS 由 SPI 外设硬件控制
+	gpio_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+	gpio_conf.pull_up_en = GPIO_PULLUP_ENABLE;
+	ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_config(&gpio_conf));
+
+	gpio_conf.mode = GPIO_MODE_INPUT;
+	gpio_conf.intr_type = GPIO_INTR_NEGEDGE;     //BUSY 下降沿表示控制器空闲
+	gpio_conf.pin_bit_mask = (0x1ULL<<busy);
+	ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_config(&gpio_conf));
+
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)   //ISR 服务可能已被其他模块安装
+    {
+        ESP_ERROR_CHECK_WITHOUT_ABORT(ret);
+    }
+    ESP_ERROR_CHECK_WITHOUT_ABORT(gpio_isr_handler_add((gpio_num_t)busy, busy_isr_handler, this));
+
+    set_rst(1);
+}
+
+/* 传输开始前根据槽位记录的电平设置 DC, 命令和数据可以混排在同一个队列里 */
+void IRAM_ATTR epaper_transport_spi::spi_pre_transfer_cb(spi_transaction_t *t) {
+    epd_spi_slot_t *slot = (epd_spi_slot_t *)t->user;
+    gpio_set_level((gpio_num_t)slot->dc_pin, slot->dc_level);
+}
+
+void IRAM_ATTR epaper_transport_spi::spi_post_transfer_cb(spi_transaction_t *t) {
+    epd_spi_slot_t *slot = (epd_spi_slot_t *)t->user;
+    slot->owner->spi_isr_done_seq = slot->seq;
+    epd_spi_done_cb_t cb = __atomic_exchange_n(&slot->done_cb, (epd_spi_done_cb_t)NULL, __ATOMIC_ACQ_REL);
+    if (cb)
+    {
+        cb(slot->done_arg);
+    }
+}
+
+void epaper_transport_spi::spi_port_init(int max_transfer_sz) {
+    int mosi = lcd_spi_data.mosi;
+    int scl = lcd_spi_data.scl;
+    int spi_host = lcd_spi_data.spi_host;
+    esp_err_t ret;
+  	spi_bus_config_t buscfg = {};
+  	  	buscfg.miso_io_num = -1;
+  	  	buscfg.mosi_io_num = mosi;
+  	  	buscfg.sclk_io_num = scl;
+  	  	buscfg.quadwp_io_num = -1;
+  	  	buscfg.quadhd_io_num = -1;
+  	  	buscfg.max_transfer_sz = max_transfer_sz;
+
+  	spi_device_interface_config_t devcfg = {};
+  	  	devcfg.spics_io_num = lcd_spi_data.cs;
+  	  	devcfg.clock_speed_hz = 40 * 1000 * 1000;  //Clock out at 40 MHz
+  	  	devcfg.mode = 0;                           //SPI mode 0
+  	  	devcfg.queue_size = EPD_SPI_QUEUE_SIZE;    //We want to be able to queue 7 transactions at a time
+  	  	devcfg.pre_cb = spi_pre_transfer_cb;       //DC 由回调驱动
+  	  	devcfg.post_cb = spi_post_transfer_cb;
+
+  	ret = spi_bus_initialize((spi_host_device_t)spi_host, &buscfg, SPI_DMA_CH_AUTO);
+  	ESP_ERROR_CHECK(ret);
+  	ret = spi_bus_add_device((spi_host_device_t)spi_host, &devcfg, &spi);
+  	ESP_ERROR_CHECK(ret);
+    spi_devcfg = devcfg;    //读寄存器时临时换成三线设备, 之后按原配置重新挂载
+}
+
+void IRAM_ATTR epaper_transport_spi::busy_isr_handler(void *arg) {
+    epaper_transport_spi *self = (epaper_transport_spi *)arg;
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(self->busy_sem, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void epaper_transport_spi::wait_busy() {
+    int busy = lcd_spi_data.busy;
+    wait(fence(NULL, NULL));   //先确保之前排队的命令都已发出
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_acquire(pm_lock);
+#endif
+    while(gpio_get_level((gpio_num_t)busy) == 1)
+	{
+        //LOW: idle, HIGH: busy. 由 BUSY 下降沿中断唤醒, 超时只作兜底
+        xSemaphoreTake(busy_sem, pdMS_TO_TICKS(EPD_BUSY_POLL_MS));
+    }
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_release(pm_lock);
+#endif
+}
+
+void epaper_transport_spi::set_rst(int level) {
+    gpio_set_level((gpio_num_t)lcd_spi_data.rst, level);
+}
+
+void epaper_transport_spi::delay_ms(uint32_t ms) {
+    vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+/* 取回一个已完成的传输, 释放其队列槽位 */
+void epaper_transport_spi::spi_reap_one() {
+    spi_transaction_t *rt = NULL;
+    esp_err_t ret = spi_device_get_trans_result(spi, &rt, portMAX_DELAY);
+    assert(ret == ESP_OK);
+    spi_in_flight--;
+    spi_done_seq = ((epd_spi_slot_t *)rt->user)->seq;
+}
+
+/* 把一段命令或数据挂到 DMA 队列上; len <= 4 时直接放在 tx_data 里 */
+void epaper_transport_spi::queue(uint8_t dc_level, const uint8_t *data, int len) {
+    if (spi_in_flight == EPD_SPI_QUEUE_SIZE)
+    {
+        spi_reap_one();
+    }
+
+    epd_spi_slot_t *slot = &spi_slots[spi_slot_head];
+    spi_slot_head = (spi_slot_head + 1) % EPD_SPI_QUEUE_SIZE;
+
+    memset(&slot->t, 0, sizeof(slot->t));
+    slot->t.length = 8 * len;
+    slot->t.user = slot;
+    if (len <= 4)
+    {
+        slot->t.flags = SPI_TRANS_USE_TXDATA;
+        memcpy(slot->t.tx_data, data, len);
+    }
+    else
+    {
+        slot->t.tx_buffer = data;
+    }
+    slot->owner = this;
+    slot->dc_pin = lcd_spi_data.dc;
+    slot->dc_level = dc_level;
+    slot->done_cb = NULL;
+    slot->done_arg = NULL;
+    slot->seq = ++spi_queued_seq;
+
+    esp_err_t ret = spi_device_queue_trans(spi, &slot->t, portMAX_DELAY);
+    assert(ret == ESP_OK);
+    spi_in_flight++;
+    spi_stats.transactions++;
+    spi_stats.bytes += len;
+}
+
+/* cb 挂到最后一个传输上, 在 SPI 中断上下文 (post_cb) 中被调用 */
+uint32_t epaper_transport_spi::fence(epd_spi_done_cb_t cb, void *arg) {
+    if (cb)
+    {
+        if (spi_in_flight == 0)
+        {
+            cb(arg);
+        }
+        else
+        {
+            epd_spi_slot_t *last = &spi_slots[(spi_slot_head + EPD_SPI_QUEUE_SIZE - 1) % EPD_SPI_QUEUE_SIZE];
+            last->done_arg = arg;
+            __atomic_store_n(&last->done_cb, cb, __ATOMIC_RELEASE);
+            /* 挂上回调前传输可能已经完成, 谁先取走 done_cb 谁负责调用 */
+            if ((int32_t)(spi_isr_done_seq - last->seq) >= 0)
+            {
+                epd_spi_done_cb_t late = __atomic_exchange_n(&last->done_cb, (epd_spi_done_cb_t)NULL, __ATOMIC_ACQ_REL);
+                if (late)
+                {
+                    late(arg);
+                }
+            }
+        }
+    }
+    return spi_queued_seq;
+}
+
+void epaper_transport_spi::wait(uint32_t ticket) {
+    while (spi_in_flight && (int32_t)(spi_done_seq - ticket) < 0)
+    {
+        spi_reap_one();
+    }
+}
+
+void epaper_transport_spi::get_stats(epd_spi_stats_t *stats) {
+    *stats = spi_stats;
+}
+
+/*
+ * 板上没有 MISO, 读操作按 SSD1681 的三线方式在 SDA 上进行: 临时把 SPI 设备换成半双工三线 + 低时钟,
+ * 读完按原配置重新挂载.
+ */
+bool epaper_transport_spi::read(uint8_t cmd, uint8_t *data, int len) {
+    if (len > 4)
+    {
+        return false;
+    }
+    wait(fence(NULL, NULL));
+
+    spi_host_device_t host = (spi_host_device_t)lcd_spi_data.spi_host;
+    ESP_ERROR_CHECK(spi_bus_remove_device(spi));
+
+    spi_device_interface_config_t rdcfg = {};
+        rdcfg.spics_io_num = lcd_spi_data.cs;
+        rdcfg.clock_speed_hz = EPD_SPI_READ_HZ;
+        rdcfg.mode = 0;
+        rdcfg.queue_size = 1;
+        rdcfg.flags = SPI_DEVICE_3WIRE | SPI_DEVICE_HALFDUPLEX;
+        rdcfg.pre_cb = spi_pre_transfer_cb;
+    spi_device_handle_t rd = NULL;
+    bool ok = spi_bus_add_device(host, &rdcfg, &rd) == ESP_OK;
+    if (ok)
+    {
+        epd_spi_slot_t c = {};
+        c.dc_pin = lcd_spi_data.dc;
+        c.dc_level = 0;
+        c.t.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_CS_KEEP_ACTIVE;  //命令与读数之间 CS 保持有效
+        c.t.length = 8;
+        c.t.tx_data[0] = cmd;
+        c.t.user = &c;
+
+        epd_spi_slot_t d = {};
+        d.dc_pin = lcd_spi_data.dc;
+        d.dc_level = 1;
+        d.t.flags = SPI_TRANS_USE_RXDATA;
+        d.t.rxlength = 8 * len;
+        d.t.user = &d;
+
+        spi_device_acquire_bus(rd, portMAX_DELAY);
+        ok = spi_device_polling_transmit(rd, &c.t) == ESP_OK &&
+             spi_device_polling_transmit(rd, &d.t) == ESP_OK;
+        spi_device_release_bus(rd);
+        spi_bus_remove_device(rd);
+        if (ok)
+        {
+            memcpy(data, d.t.rx_data, len);
+        }
+    }
+    ESP_ERROR_CHECK(spi_bus_add_device(host, &spi_devcfg, &spi));
+    return ok;
+}
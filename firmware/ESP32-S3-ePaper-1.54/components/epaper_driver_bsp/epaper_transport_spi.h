@@ -0,0 +1,67 @@
+#ifndef EPAPER_TRANSPORT_SPI_H
+#define EPAPER_TRANSPORT_SPI_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "driver/spi_master.h"
+#include "driver/gpio.h"
+#include "esp_pm.h"
+#include "epaper_transport.h"
+
+#define EPD_SPI_QUEUE_SIZE   7      /* 与 spi_device_interface_config_t::queue_size 一致 */
+#define EPD_SPI_READ_HZ      (1 * 1000 * 1000)   /* 三线读寄存器时的时钟 */
+#define EPD_BUSY_POLL_MS     100    /* 等待 BUSY 中断的兜底超时 */
+
+class epaper_transport_spi;
+
+/* 预分配的 DMA 队列槽位 */
+typedef struct {
+    spi_transaction_t t;
+    epaper_transport_spi *owner;
+    uint8_t dc_pin;
+    uint8_t dc_level;
+    uint32_t seq;
+    epd_spi_done_cb_t done_cb;
+    void *done_arg;
+}epd_spi_slot_t;
+
+/* spi_master DMA 队列 + GPIO 的传输实现, DC 由 pre_cb 驱动, BUSY 下降沿中断唤醒等待者 */
+class epaper_transport_spi : public epaper_transport {
+private:
+    const custom_lcd_spi_t lcd_spi_data;
+    spi_device_handle_t spi;
+    spi_device_interface_config_t spi_devcfg = {};
+    SemaphoreHandle_t busy_sem = NULL;          /* BUSY 下降沿中断释放 */
+#if CONFIG_PM_ENABLE
+    esp_pm_lock_handle_t pm_lock = NULL;        /* 等 BUSY 期间禁止 light sleep, 否则边沿中断唤醒不了 CPU */
+#endif
+
+    epd_spi_slot_t spi_slots[EPD_SPI_QUEUE_SIZE];
+    int spi_slot_head = 0;
+    int spi_in_flight = 0;
+    uint32_t spi_queued_seq = 0;
+    uint32_t spi_done_seq = 0;
+    volatile uint32_t spi_isr_done_seq = 0;
+    epd_spi_stats_t spi_stats = {};
+
+    void spi_gpio_init();
+    void spi_port_init(int max_transfer_sz);
+    void spi_reap_one();
+    static void spi_pre_transfer_cb(spi_transaction_t *t);
+    static void spi_post_transfer_cb(spi_transaction_t *t);
+    static void busy_isr_handler(void *arg);
+
+public:
+    epaper_transport_spi(custom_lcd_spi_t _lcd_spi_data, int max_transfer_sz);
+
+    void queue(uint8_t dc_level, const uint8_t *data, int len) override;
+    uint32_t fence(epd_spi_done_cb_t cb, void *arg) override;
+    void wait(uint32_t ticket) override;
+    void set_rst(int level) override;
+    void wait_busy() override;
+    bool read(uint8_t cmd, uint8_t *data, int len) override;
+    void delay_ms(uint32_t ms) override;
+    void get_stats(epd_spi_stats_t *stats) override;
+};
+
+#endif
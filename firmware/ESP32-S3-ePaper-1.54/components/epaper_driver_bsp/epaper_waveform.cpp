@@ -0,0 +1,187 @@
+#include <string.h>
+#include "epaper_waveform.h"
+
+static const uint8_t WF_Full_1IN54[EPD_LUT_LEN] =
+{											
+    0x80,	0x48,	0x40,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
+    0x40,	0x48,	0x80,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
+    0x80,	0x48,	0x40,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
+    0x40,	0x48,	0x80,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
+    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,
+    0xA,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x8,	0x1,	0x0,	0x8,	0x1,	0x0,	0x2,					
+    0xA,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x0,	0x0,	0x0,	0x0,	0x0,	0x0,	0x0,					
+    0x22,	0x22,	0x22,	0x22,	0x22,	0x22,	0x0,	0x0,	0x0,			
+    0x22,	0x17,	0x41,	0x0,	0x32,	0x20
+};
+
+static const uint8_t WF_PARTIAL_1IN54_0[EPD_LUT_LEN] =
+{
+    0x0,0x40,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x80,0x80,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x40,0x40,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x80,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0xF,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x1,0x1,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x22,0x22,0x22,0x22,0x22,0x22,0x0,0x0,0x0,
+    0x02,0x17,0x41,0xB0,0x32,0x28,
+};
+
+/* 驱动帧数减半且去掉收尾帧, 用于时钟等小区域; 残影更重, 依赖定期全刷清除 */
+static const uint8_t WF_FAST_PARTIAL_1IN54[EPD_LUT_LEN] =
+{
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x80,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x40,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x8,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x22,0x22,0x22,0x22,0x22,0x22,0x0,0x0,0x0,
+    0x2,0x17,0x41,0xB0,0x32,0x28,
+};
+
+/*
+ * 只驱动发生变化的像素, 不变像素不再补一帧, 闪烁更少, 适合纯文字.
+ * 第 0 组 TP 保持参考局部波形的 0xF 帧, 常温下的缩短交给 temp_bands 按温度统一处理.
+ */
+static const uint8_t WF_TEXT_1IN54[EPD_LUT_LEN] =
+{
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x80,0x80,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x40,0x40,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0xF,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x1,0x1,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x0,0x0,0x0,0x0,0x0,0x0,0x0,
+    0x22,0x22,0x22,0x22,0x22,0x22,0x0,0x0,0x0,
+    0x2,0x17,0x41,0xB0,0x32,0x28,
+};
+
+static const epd_waveform_t waveforms[EPD_WF_COUNT] = {
+    {"partial", WF_PARTIAL_1IN54_0, 0xcf, true},
+    {"fast", WF_FAST_PARTIAL_1IN54, 0xcf, true},
+    {"text", WF_TEXT_1IN54, 0xcf, true},
+    {"full", WF_Full_1IN54, 0xc7, false},
+};
+
+/* 各档的起始温度与局部波形帧数比例; 原表按低温最坏情况设计, 温度越高液体粘度越低, 所需帧数越少 */
+static const struct {
+    int16_t min_x16;
+    uint8_t percent;
+} temp_bands[EPD_TEMP_BANDS] = {
+    {INT16_MIN, 100},
+    {15 * 16, 80},
+    {25 * 16, 65},
+};
+
+#define LUT_TP_OFFSET   60      /* 12 组 TP/RP, 每组 7 字节: TPA TPB SRAB TPC TPD SRCD RP */
+#define LUT_GROUPS      12
+
+const epd_waveform_t *epd_waveform_get(epd_waveform_id_t id) {
+    if (id < 0 || id >= EPD_WF_COUNT)
+    {
+        return NULL;
+    }
+    return &waveforms[id];
+}
+
+epd_waveform_id_t epd_waveform_find(const char *name) {
+    for (int i = 0; i < EPD_WF_COUNT; i++)
+    {
+        if (strcmp(waveforms[i].name, name) == 0)
+        {
+            return (epd_waveform_id_t)i;
+        }
+    }
+    return EPD_WF_NONE;
+}
+
+int epd_waveform_temp_band(int16_t temp_x16, int cur) {
+    int band = 0;
+    for (int i = EPD_TEMP_BANDS - 1; i > 0; i--)
+    {
+        if (temp_x16 >= temp_bands[i].min_x16)
+        {
+            band = i;
+            break;
+        }
+    }
+    if (band == cur || cur < 0 || cur >= EPD_TEMP_BANDS)
+    {
+        return band;
+    }
+    /* 滞回: 升档需超过边界 1 °C, 降档需低于边界 1 °C */
+    if (band > cur && temp_x16 < temp_bands[band].min_x16 + 16)
+    {
+        return cur;
+    }
+    if (band < cur && temp_x16 >= temp_bands[cur].min_x16 - 16)
+    {
+        return cur;
+    }
+    return band;
+}
+
+void epd_waveform_build(epd_waveform_id_t id, int band, uint8_t *out) {
+    const epd_waveform_t *wf = epd_waveform_get(id);
+    memcpy(out, wf->lut, EPD_LUT_LEN);
+    if (!wf->partial || band <= 0 || band >= EPD_TEMP_BANDS)
+    {
+        return;
+    }
+    const uint32_t percent = temp_bands[band].percent;
+    static const uint8_t phases[4] = {0, 1, 3, 4};
+    for (int g = 0; g < LUT_GROUPS; g++)
+    {
+        for (int k = 0; k < 4; k++)
+        {
+            uint8_t *tp = &out[LUT_TP_OFFSET + g * 7 + phases[k]];
+            if (*tp)
+            {
+                uint32_t v = (*tp * percent + 99) / 100;    //向上取整, 非零相位至少保留 1 帧
+                *tp = (uint8_t)v;
+            }
+        }
+    }
+}
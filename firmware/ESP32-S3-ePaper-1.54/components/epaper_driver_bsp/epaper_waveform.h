@@ -0,0 +1,50 @@
+#ifndef EPAPER_WAVEFORM_H
+#define EPAPER_WAVEFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EPD_LUT_LEN     159     /* 153 字节 LUT + EOPT/VGH/VSH1/VSH2/VSL/VCOM */
+#define EPD_TEMP_BANDS  3       /* 局部波形的温度档数, 第 0 档为原表 (最坏情况) */
+
+/* 已注册的波形; EPD_WF_PARTIAL 为 0, 策略结构体清零时即为默认局部波形 */
+typedef enum {
+    EPD_WF_NONE = -1,           /* 控制器中的 LUT 未知 (复位或深睡后) */
+    EPD_WF_PARTIAL = 0,         /* 标准局部刷新 */
+    EPD_WF_FAST_PARTIAL,        /* 快速局部刷新, 用于时钟等小区域 */
+    EPD_WF_TEXT,                /* 只驱动变化像素, 用于纯文字 */
+    EPD_WF_FULL,                /* 全刷 */
+    EPD_WF_COUNT,
+}epd_waveform_id_t;
+
+typedef struct {
+    const char *name;
+    const uint8_t *lut;         /* EPD_LUT_LEN 字节 */
+    uint8_t update_ctrl;        /* 0x22 的参数 */
+    bool partial;               /* 需要局部刷新模式的寄存器设置 (0x37/0x3C) */
+}epd_waveform_t;
+
+/* 每种波形的使用统计, 时间为 0x20 发出到 BUSY 变低 */
+typedef struct {
+    uint32_t runs;
+    uint32_t uploads;           /* 实际上传 LUT 的次数 */
+    uint32_t uploads_skipped;   /* 控制器中已是该 LUT 而省掉的上传 */
+    uint32_t last_us;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t total_us;
+}epd_waveform_stats_t;
+
+const epd_waveform_t *epd_waveform_get(epd_waveform_id_t id);   /* id 无效时返回 NULL */
+epd_waveform_id_t epd_waveform_find(const char *name);           /* 未找到时返回 EPD_WF_NONE */
+
+/*
+ * 温度 (1/16 °C) 所在的档位. cur 为当前档位, 离档位边界不足 1 °C 时保持不变, 避免来回切换 LUT.
+ * 温度未知时应使用第 0 档.
+ */
+int epd_waveform_temp_band(int16_t temp_x16, int cur);
+
+/* 生成 id 在 band 档下的 LUT: 局部波形按档位缩短各相位帧数, 全刷波形原样拷贝 */
+void epd_waveform_build(epd_waveform_id_t id, int band, uint8_t *out);
+
+#endif
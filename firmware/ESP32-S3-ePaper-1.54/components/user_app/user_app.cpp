@@ -2,6 +2,7 @@
 #include "freertos/FreeRTOS.h"
 #include "user_app.h"
 #include "driver/gpio.h"
+#include "driver/spi_master.h"
 #include "user_config.h"
 #include "board_power_bsp.h"
 #include "gui_guider.h"
@@ -14,10 +15,26 @@
 #include "button_bsp.h"
 
 epaper_driver_display *driver = NULL;
+epaper_refresh_scheduler *refresh_sched = NULL;
+epaper_frame_store *frame_store = NULL;
 board_power_bsp_t board_div(EPD_PWR_PIN,Audio_PWR_PIN,VBAT_PWR_PIN);
 
 lv_ui src_ui;
 
+static_assert(EPD_WIDTH == epaper_driver_display::Width && EPD_HEIGHT == epaper_driver_display::Height,
+              "EPD_WIDTH/EPD_HEIGHT must match the panel traits");
+
+static void epd_rail_hook(bool on, void *arg)
+{
+    if (on)
+    {
+        board_div.POWEER_EPD_ON();
+    }
+    else
+    {
+        board_div.POWEER_EPD_OFF();
+    }
+}
 
 void user_app_init(void)
 {
@@ -32,12 +49,43 @@ void user_app_init(void)
         driver_config.mosi = EPD_MOSI_PIN;
         driver_config.scl = EPD_SCK_PIN;
         driver_config.spi_host = EPD_SPI_NUM;
-        driver_config.buffer_len  = 5000;
-    driver = new epaper_driver_display(EPD_WIDTH,EPD_HEIGHT,driver_config);
-    driver->EPD_Init();
-    driver->EPD_Clear();
-    driver->EPD_DisplayPartBaseImage();
-    driver->EPD_Init_Partial();            //局部刷新初始化
+    driver = new epaper_driver_display(driver_config);
+    driver->EPD_SetRotation(EPD_ROTATION, EPD_MIRROR);
+    frame_store = new epaper_frame_store(EPD_FRAME_STORE_LABEL, EPD_WIDTH, EPD_HEIGHT,
+                                         epaper_driver_display::Stride * EPD_HEIGHT, EPD_FRAME_STORE_MIN_S);
+    driver->EPD_SetFrameStore(frame_store);
+    /*屏幕上保留着上次的画面, 读回后直接作为局部刷新的参考; 没有保存过才清屏*/
+    bool restored = driver->EPD_RestoreFrame();
+    if (!restored)
+    {
+        driver->EPD_Init();
+        driver->EPD_Clear();
+        driver->EPD_DisplayPartBaseImage();
+        driver->EPD_Init_Partial();            //局部刷新初始化
+    }
+
+    /*全刷/局部刷新策略*/
+    epd_refresh_policy_t policy = {};
+        policy.max_partials = EPD_FULL_MAX_PARTIALS;
+        policy.max_changed_px = EPD_FULL_MAX_CHANGED_PX;
+        policy.max_interval_s = EPD_FULL_MAX_INTERVAL_S;
+        policy.quiet_hour = EPD_FULL_QUIET_HOUR;
+        policy.defer_percent = EPD_FULL_DEFER_PERCENT;
+        policy.partial_wf = EPD_PARTIAL_WAVEFORM;
+        policy.fast_max_px = EPD_FAST_MAX_PX;
+    refresh_sched = new epaper_refresh_scheduler(policy);
+    refresh_sched->load();
+    if (!restored)
+    {
+        refresh_sched->on_full();          //开机底图是一次全刷
+    }
+    driver->EPD_SetScheduler(refresh_sched);
+    driver->EPD_SetCoalesceWindow(EPD_COALESCE_MS);
+    driver->EPD_SetPackMode(EPD_PACK_DEFAULT_MODE);
+
+    /*空闲时面板深睡, 需要刷新时由驱动自动唤醒*/
+    driver->EPD_SetPowerHook(epd_rail_hook, NULL);
+    driver->EPD_SetAutoSleep(EPD_AUTO_SLEEP_MS, EPD_AUTO_SLEEP_RAIL_OFF);
 }
 
 void led_test_task(void *arg)
@@ -76,6 +124,7 @@ void loop_lvgl_img(void *arg)
 void user_ui_init(void)
 {
     setup_ui(&src_ui);
+    driver->EPD_AddPackRegion(0, 0, driver->EPD_GetWidth() - 1, driver->EPD_GetHeight() - 1, EPD_PACK_DITHER); //整屏图片, 用抖动
     xTaskCreatePinnedToCore(led_test_task, "led_test_task", 4 * 1024, NULL, 4, NULL,1);
     xTaskCreatePinnedToCore(loop_lvgl_img, "loop_lvgl_img", 4 * 1024, &src_ui, 4, NULL,1);
 }
\ No newline at end of file
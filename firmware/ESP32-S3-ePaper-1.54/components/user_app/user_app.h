@@ -4,6 +4,7 @@
 #include "epaper_driver_bsp.h"
 
 extern epaper_driver_display *driver;
+extern epaper_refresh_scheduler *refresh_sched;
 
 #ifdef __cplusplus
 extern "C" {
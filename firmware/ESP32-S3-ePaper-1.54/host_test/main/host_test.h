@@ -0,0 +1,15 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdint.h>
+#include "esp_timer.h"
+
+/* 固定种子的伪随机数 (xorshift32), 每次运行生成的帧相同, 失败可复现 */
+void host_srand(uint32_t seed);
+uint32_t host_rand(void);
+void host_fill_random(uint8_t *buf, int len);
+
+/* 基准结果统一输出一行, 便于 grep 和前后对比 */
+void host_bench_report(const char *name, int64_t total_us, int iters, const char *unit);
+
+#endif
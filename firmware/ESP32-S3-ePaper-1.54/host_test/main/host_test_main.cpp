@@ -0,0 +1,46 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "unity.h"
+#include "unity_fixture.h"
+#include "host_test.h"
+
+static uint32_t rand_state = 1;
+
+void host_srand(uint32_t seed) {
+    rand_state = seed ? seed : 1;
+}
+
+uint32_t host_rand(void) {
+    uint32_t x = rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rand_state = x;
+    return x;
+}
+
+void host_fill_random(uint8_t *buf, int len) {
+    for (int i = 0; i < len; i++)
+    {
+        buf[i] = (uint8_t)host_rand();
+    }
+}
+
+void host_bench_report(const char *name, int64_t total_us, int iters, const char *unit) {
+    printf("BENCH %-32s %10.2f us/%s (%d runs)\n", name, (double)total_us / iters, unit, iters);
+}
+
+static void run_all_tests(void) {
+    RUN_TEST_GROUP(emulator);
+    RUN_TEST_GROUP(transport);
+    RUN_TEST_GROUP(diff);
+    RUN_TEST_GROUP(scheduler);
+    RUN_TEST_GROUP(pack);
+    RUN_TEST_GROUP(rotate);
+}
+
+extern "C" void app_main(void) {
+    const char *argv[] = {"epaper_host_test", "-v"};
+    int failures = UnityMain(2, argv, run_all_tests);
+    exit(failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,174 @@
+#include <string.h>
+#include "unity.h"
+#include "unity_fixture.h"
+#include "epaper_frame_diff.h"
+#include "epaper_panel.h"
+#include "host_test.h"
+
+#define W       epd_panel_1in54::width
+#define H       epd_panel_1in54::height
+#define STRIDE  epd_panel_1in54::stride
+#define FB_LEN  epd_panel_1in54::fb_bytes
+
+static uint8_t shown[FB_LEN] __attribute__((aligned(4)));
+static uint8_t frame[FB_LEN] __attribute__((aligned(4)));
+
+/* 逐字节比较的参考实现: 只统计 req 内的变化, 返回外接矩形 (X 按字节) 和变化像素数 */
+static bool ref_diff(const epd_window_t *req, epd_window_t *bbox, uint32_t *px) {
+    bool any = false;
+    *px = 0;
+    for (int y = req->y1; y <= req->y2; y++)
+    {
+        for (int c = req->x1 >> 3; c <= req->x2 >> 3; c++)
+        {
+            const uint8_t x = shown[y * STRIDE + c] ^ frame[y * STRIDE + c];
+            if (x == 0)
+            {
+                continue;
+            }
+            *px += __builtin_popcount(x);
+            const uint16_t x1 = c << 3;
+            const uint16_t x2 = x1 + 7;
+            if (!any)
+            {
+                *bbox = (epd_window_t){x1, (uint16_t)y, x2, (uint16_t)y};
+                any = true;
+                continue;
+            }
+            if (x1 < bbox->x1) bbox->x1 = x1;
+            if (x2 > bbox->x2) bbox->x2 = x2;
+            bbox->y2 = y;
+        }
+    }
+    return any;
+}
+
+static bool covered(const epd_diff_t *d, int x, int y) {
+    for (int i = 0; i < d->count; i++)
+    {
+        const epd_window_t *b = &d->bands[i];
+        if (x >= b->x1 && x <= b->x2 && y >= b->y1 && y <= b->y2)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 在 frame 中随机翻转 n 个字节里的若干位 */
+static void sprinkle(int n) {
+    for (int i = 0; i < n; i++)
+    {
+        const int off = host_rand() % FB_LEN;
+        frame[off] ^= (uint8_t)(host_rand() | 1);
+    }
+}
+
+static void random_req(epd_window_t *req) {
+    int x1 = host_rand() % W, x2 = host_rand() % W;
+    int y1 = host_rand() % H, y2 = host_rand() % H;
+    if (x1 > x2) { int t = x1; x1 = x2; x2 = t; }
+    if (y1 > y2) { int t = y1; y1 = y2; y2 = t; }
+    *req = (epd_window_t){(uint16_t)(x1 & ~7), (uint16_t)y1, (uint16_t)(x2 | 7), (uint16_t)y2};
+    if (req->x2 >= W) req->x2 = W - 1;
+}
+
+TEST_GROUP(diff);
+
+TEST_SETUP(diff) {
+    host_srand(0xd1ff);
+}
+
+TEST_TEAR_DOWN(diff) {
+}
+
+TEST(diff, identical_frames_are_skipped) {
+    host_fill_random(shown, FB_LEN);
+    memcpy(frame, shown, FB_LEN);
+    const epd_window_t full = {0, 0, W - 1, H - 1};
+    epd_diff_t d;
+    TEST_ASSERT_FALSE(epd_frame_diff(shown, frame, W, H, &full, &d));
+    TEST_ASSERT_EQUAL(0, d.count);
+    TEST_ASSERT_EQUAL(0, d.changed_px);
+}
+
+/* 字宽内核与逐字节参考比较: 外接矩形一致, 每个变化字节都被某个窗口覆盖, 窗口有序且不重叠 */
+TEST(diff, word_kernel_matches_bytewise_reference) {
+    for (int iter = 0; iter < 2000; iter++)
+    {
+        host_fill_random(shown, FB_LEN);
+        memcpy(frame, shown, FB_LEN);
+        sprinkle(host_rand() % 24);
+        epd_window_t req;
+        if (iter & 1)
+        {
+            req = (epd_window_t){0, 0, W - 1, H - 1};
+        }
+        else
+        {
+            random_req(&req);
+        }
+
+        epd_window_t bbox = {0, 0, 0, 0};
+        uint32_t px;
+        const bool expect = ref_diff(&req, &bbox, &px);
+        epd_diff_t d;
+        TEST_ASSERT_EQUAL(expect, epd_frame_diff(shown, frame, W, H, &req, &d));
+        TEST_ASSERT_EQUAL(px, d.changed_px);
+        if (!expect)
+        {
+            continue;
+        }
+        TEST_ASSERT_EQUAL(bbox.x1, d.bbox.x1);
+        TEST_ASSERT_EQUAL(bbox.x2, d.bbox.x2);
+        TEST_ASSERT_EQUAL(bbox.y1, d.bbox.y1);
+        TEST_ASSERT_EQUAL(bbox.y2, d.bbox.y2);
+        TEST_ASSERT_TRUE(d.count >= 1 && d.count <= EPD_DIFF_MAX_BANDS);
+        for (int i = 1; i < d.count; i++)
+        {
+            TEST_ASSERT_GREATER_THAN(d.bands[i - 1].y2, d.bands[i].y1);
+        }
+        for (int y = req.y1; y <= req.y2; y++)
+        {
+            for (int c = req.x1 >> 3; c <= req.x2 >> 3; c++)
+            {
+                if (shown[y * STRIDE + c] != frame[y * STRIDE + c])
+                {
+                    TEST_ASSERT_TRUE(covered(&d, c << 3, y));
+                }
+            }
+        }
+    }
+}
+
+TEST(diff, bench_kernel) {
+    host_fill_random(shown, FB_LEN);
+    memcpy(frame, shown, FB_LEN);
+    const epd_window_t full = {0, 0, W - 1, H - 1};
+    const int iters = 2000;
+    epd_diff_t d;
+    volatile int sink = 0;
+
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < iters; i++)
+    {
+        sink += epd_frame_diff(shown, frame, W, H, &full, &d);
+    }
+    host_bench_report("diff unchanged 200x200", esp_timer_get_time() - t0, iters, "frame");
+
+    frame[20 * STRIDE + 3] ^= 0x10;
+    frame[150 * STRIDE + 20] ^= 0x01;
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < iters; i++)
+    {
+        sink += epd_frame_diff(shown, frame, W, H, &full, &d);
+    }
+    host_bench_report("diff two dirty bytes 200x200", esp_timer_get_time() - t0, iters, "frame");
+    TEST_ASSERT_EQUAL(2, d.count);
+}
+
+TEST_GROUP_RUNNER(diff) {
+    RUN_TEST_CASE(diff, identical_frames_are_skipped);
+    RUN_TEST_CASE(diff, word_kernel_matches_bytewise_reference);
+    RUN_TEST_CASE(diff, bench_kernel);
+}
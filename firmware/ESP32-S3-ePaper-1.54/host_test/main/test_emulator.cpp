@@ -0,0 +1,259 @@
+#include <string.h>
+#include "unity.h"
+#include "unity_fixture.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "epaper_driver_bsp.h"
+#include "epaper_emulator.h"
+#include "host_test.h"
+
+/* 驱动经 epaper_transport 接到模拟器上, 每个用例都是新上电的控制器 */
+
+#define FB_LEN  (epaper_driver_display::Stride * epaper_driver_display::Height)
+
+static epaper_emulator *emu;
+static epaper_driver_display *drv;
+static uint8_t ram[FB_LEN];
+
+TEST_GROUP(emulator);
+
+TEST_SETUP(emulator) {
+    host_srand(0x5eed);
+    emu = new epaper_emulator(epaper_driver_display::Width, epaper_driver_display::Height);
+    drv = new epaper_driver_display(emu);
+}
+
+TEST_TEAR_DOWN(emulator) {
+    delete drv;
+    delete emu;
+}
+
+/* 控制器 RAM (0x24/0x26) 和面板 (0) 的内容都应等于 expect */
+static void assert_ram(uint8_t which, const uint8_t *expect) {
+    TEST_ASSERT_TRUE(emu->read_ram(which, ram));
+    TEST_ASSERT_EQUAL_MEMORY(expect, ram, FB_LEN);
+}
+
+static void assert_clean_stream(void) {
+    epd_emu_stats_t st;
+    emu->get_emu_stats(&st);
+    TEST_ASSERT_EQUAL(0, st.unknown_cmds);
+    TEST_ASSERT_EQUAL(0, st.busy_violations);
+    TEST_ASSERT_EQUAL(0, st.sleep_violations);
+}
+
+TEST(emulator, base_image_fills_both_banks) {
+    drv->EPD_Init();
+    drv->EPD_Clear();
+    host_fill_random(drv->EPD_GetFrameBuffer(), FB_LEN);
+    uint8_t frame[FB_LEN];
+    memcpy(frame, drv->EPD_GetFrameBuffer(), FB_LEN);
+    drv->EPD_DisplayPartBaseImage();
+
+    assert_ram(0x24, frame);
+    assert_ram(0x26, frame);
+    assert_ram(0, frame);
+    for (int y = 0; y < epaper_driver_display::Height; y += 37)
+    {
+        for (int x = 0; x < epaper_driver_display::Width; x += 13)
+        {
+            const bool white = (frame[y * epaper_driver_display::Stride + (x >> 3)] << (x & 0x07)) & 0x80;
+            TEST_ASSERT_EQUAL(white, emu->pixel(x, y));
+        }
+    }
+
+    epd_emu_update_t up;
+    emu->get_last_update(&up);
+    TEST_ASSERT_FALSE(up.partial);
+    TEST_ASSERT_EQUAL(0, up.stale_px);
+    TEST_ASSERT_GREATER_THAN(0, up.frames);     //驱动上传了全刷 LUT, 不是 OTP 波形
+    assert_clean_stream();
+}
+
+TEST(emulator, full_display_syncs_old_bank) {
+    drv->EPD_Init();
+    drv->EPD_Clear();
+    drv->EPD_DisplayPartBaseImage();
+    host_fill_random(drv->EPD_GetFrameBuffer(), FB_LEN);
+    uint8_t frame[FB_LEN];
+    memcpy(frame, drv->EPD_GetFrameBuffer(), FB_LEN);
+    drv->EPD_Display();
+
+    assert_ram(0x24, frame);
+    assert_ram(0x26, frame);
+    assert_ram(0, frame);
+    assert_clean_stream();
+}
+
+TEST(emulator, deep_sleep_keeps_ram) {
+    drv->EPD_Init();
+    drv->EPD_Clear();
+    host_fill_random(drv->EPD_GetFrameBuffer(), FB_LEN);
+    uint8_t frame[FB_LEN];
+    memcpy(frame, drv->EPD_GetFrameBuffer(), FB_LEN);
+    drv->EPD_DisplayPartBaseImage();
+    drv->EPD_Sleep(false);
+
+    epd_power_stats_t ps;
+    drv->EPD_GetPowerStats(&ps);
+    TEST_ASSERT_EQUAL(EPD_POWER_SLEEP, ps.state);
+    assert_ram(0x24, frame);
+    assert_ram(0x26, frame);
+    assert_clean_stream();
+}
+
+/* 在 (x, y) 起的 w x h 像素 (x 与 w 按 8 对齐) 内填入随机内容 */
+static void scribble(uint8_t *fb, int x, int y, int w, int h) {
+    for (int r = y; r < y + h; r++)
+    {
+        host_fill_random(fb + r * epaper_driver_display::Stride + (x >> 3), w >> 3);
+    }
+}
+
+static uint32_t count_diff_px(const uint8_t *a, const uint8_t *b) {
+    uint32_t n = 0;
+    for (int i = 0; i < FB_LEN; i++)
+    {
+        n += __builtin_popcount((uint8_t)(a[i] ^ b[i]));
+    }
+    return n;
+}
+
+/* 每次局部刷新后旧图 RAM 0x26 都要跟上屏幕, 下一次波形只驱动真正变化的像素 */
+TEST(emulator, partial_refresh_keeps_banks_in_sync) {
+    drv->EPD_Init();
+    drv->EPD_Clear();
+    host_fill_random(drv->EPD_GetFrameBuffer(), FB_LEN);
+    drv->EPD_DisplayPartBaseImage();
+    drv->EPD_Init_Partial();
+
+    uint8_t prev[FB_LEN];
+    uint8_t frame[FB_LEN];
+    memcpy(prev, drv->EPD_GetFrameBuffer(), FB_LEN);
+    static const int rects[2][4] = {
+        {16, 40, 64, 30},
+        {96, 120, 80, 50},
+    };
+    for (int i = 0; i < 2; i++)
+    {
+        scribble(drv->EPD_GetFrameBuffer(), rects[i][0], rects[i][1], rects[i][2], rects[i][3]);
+        memcpy(frame, drv->EPD_GetFrameBuffer(), FB_LEN);
+        drv->EPD_DisplayPart();
+
+        assert_ram(0x24, frame);
+        assert_ram(0x26, frame);
+        assert_ram(0, frame);
+        epd_emu_update_t up;
+        emu->get_last_update(&up);
+        TEST_ASSERT_TRUE(up.partial);
+        TEST_ASSERT_EQUAL(0, up.stale_px);
+        TEST_ASSERT_EQUAL(count_diff_px(prev, frame), up.driven_px);
+        memcpy(prev, frame, FB_LEN);
+    }
+    assert_clean_stream();
+}
+
+/* 把波形的 BUSY 拦在测试手里: arm 之后的第一次带显示刷新在 wait_busy 中停住, 直到 release */
+class gated_transport : public epaper_transport {
+private:
+    epaper_emulator *inner;
+    SemaphoreHandle_t release_sem;
+    volatile bool armed = false;
+    uint32_t armed_updates = 0;
+
+public:
+    SemaphoreHandle_t entered;
+
+    gated_transport(epaper_emulator *t) : inner(t) {
+        release_sem = xSemaphoreCreateBinary();
+        entered = xSemaphoreCreateBinary();
+    }
+    ~gated_transport() {
+        vSemaphoreDelete(release_sem);
+        vSemaphoreDelete(entered);
+    }
+    void arm() {
+        epd_emu_stats_t st;
+        inner->get_emu_stats(&st);
+        armed_updates = st.updates;
+        armed = true;
+    }
+    void release() { xSemaphoreGive(release_sem); }
+
+    void queue(uint8_t dc_level, const uint8_t *data, int len) override { inner->queue(dc_level, data, len); }
+    uint32_t fence(epd_spi_done_cb_t cb, void *arg) override { return inner->fence(cb, arg); }
+    void wait(uint32_t ticket) override { inner->wait(ticket); }
+    void set_rst(int level) override { inner->set_rst(level); }
+    void wait_busy() override {
+        epd_emu_stats_t st;
+        inner->get_emu_stats(&st);
+        if (armed && st.updates > armed_updates)
+        {
+            armed = false;
+            xSemaphoreGive(entered);
+            xSemaphoreTake(release_sem, portMAX_DELAY);
+        }
+        inner->wait_busy();
+    }
+    bool read(uint8_t cmd, uint8_t *data, int len) override { return inner->read(cmd, data, len); }
+    void delay_ms(uint32_t ms) override { inner->delay_ms(ms); }
+    void get_stats(epd_spi_stats_t *stats) override { inner->get_stats(stats); }
+};
+
+static int done_log[4];
+static volatile int done_n;
+
+static void on_done(void *arg) {
+    done_log[done_n++] = (int)(intptr_t)arg;
+}
+
+/* 刷新进行中时再提交同样的内容: 没有新像素要画, 但回调必须排在进行中的刷新完成之后 */
+TEST(emulator, no_change_completion_waits_for_in_flight) {
+    gated_transport gate(emu);
+    delete drv;
+    drv = new epaper_driver_display(&gate);
+    drv->EPD_Init();
+    drv->EPD_Clear();
+    host_fill_random(drv->EPD_GetFrameBuffer(), FB_LEN);
+    drv->EPD_DisplayPartBaseImage();
+    drv->EPD_Init_Partial();
+
+    const uint16_t x2 = epaper_driver_display::Width - 1;
+    const uint16_t y2 = epaper_driver_display::Height - 1;
+    uint8_t frame[FB_LEN];
+    scribble(drv->EPD_GetFrameBuffer(), 32, 60, 48, 40);
+    memcpy(frame, drv->EPD_GetFrameBuffer(), FB_LEN);
+    done_n = 0;
+    gate.arm();
+    drv->EPD_RefreshAsync(0, 0, x2, y2, on_done, (void *)1);
+    const bool in_flight = xSemaphoreTake(gate.entered, pdMS_TO_TICKS(2000));
+
+    drv->EPD_RefreshAsync(0, 0, x2, y2, on_done, (void *)2);
+    const int early = done_n;
+    gate.release();     //先放行再断言, 失败时刷新任务不会卡在 wait_busy
+    drv->EPD_RefreshWait();
+    TEST_ASSERT_TRUE(in_flight);
+    TEST_ASSERT_EQUAL(0, early);
+    TEST_ASSERT_EQUAL(2, done_n);
+    TEST_ASSERT_EQUAL(1, done_log[0]);
+    TEST_ASSERT_EQUAL(2, done_log[1]);
+    assert_ram(0x24, frame);
+    assert_ram(0x26, frame);
+    assert_ram(0, frame);
+
+    /* 画面未变的请求在空闲时立即完成 */
+    drv->EPD_RefreshAsync(0, 0, x2, y2, on_done, (void *)3);
+    TEST_ASSERT_EQUAL(3, done_n);
+    TEST_ASSERT_EQUAL(3, done_log[2]);
+    delete drv;
+    drv = new epaper_driver_display(emu);
+    assert_clean_stream();
+}
+
+TEST_GROUP_RUNNER(emulator) {
+    RUN_TEST_CASE(emulator, base_image_fills_both_banks);
+    RUN_TEST_CASE(emulator, full_display_syncs_old_bank);
+    RUN_TEST_CASE(emulator, deep_sleep_keeps_ram);
+    RUN_TEST_CASE(emulator, partial_refresh_keeps_banks_in_sync);
+    RUN_TEST_CASE(emulator, no_change_completion_waits_for_in_flight);
+}
@@ -0,0 +1,303 @@
+#include <string.h>
+#include "unity.h"
+#include "unity_fixture.h"
+#include "epaper_pack.h"
+#include "epaper_panel.h"
+#include "epaper_driver_bsp.h"
+#include "epaper_emulator.h"
+#include "host_test.h"
+
+#define W       epd_panel_1in54::width
+#define H       epd_panel_1in54::height
+#define STRIDE  epd_panel_1in54::stride
+#define FB_LEN  epd_panel_1in54::fb_bytes
+
+static uint16_t src[W * H + 1] __attribute__((aligned(4)));
+static uint8_t fb_a[FB_LEN];
+static uint8_t fb_b[FB_LEN];
+
+static const epd_pack_mode_t modes[] = {EPD_PACK_LEGACY, EPD_PACK_LUMA, EPD_PACK_DITHER};
+
+/* x1 按 8 对齐, 宽度任意 (含不足一字节的尾巴) */
+static void random_rect(int *x1, int *y1, int *x2, int *y2) {
+    *x1 = (host_rand() % W) & ~7;
+    *x2 = *x1 + host_rand() % (W - *x1);
+    *y1 = host_rand() % H;
+    *y2 = *y1 + host_rand() % (H - *y1);
+}
+
+TEST_GROUP(pack);
+
+TEST_SETUP(pack) {
+    host_srand(0xbac4);
+}
+
+TEST_TEAR_DOWN(pack) {
+}
+
+/* LVGL 经 set_px 直接画进 1bpp 帧缓冲, 与先渲染到 RGB565 显存再整块打包的画面逐位相同 */
+TEST(pack, set_px_matches_rgb565_pack) {
+    for (int iter = 0; iter < 300; iter++)
+    {
+        const epd_pack_mode_t mode = modes[iter % 3];
+        int x1, y1, x2, y2;
+        random_rect(&x1, &y1, &x2, &y2);
+        const int w = x2 - x1 + 1;
+        host_fill_random((uint8_t *)src, w * (y2 - y1 + 1) * 2);
+        host_fill_random(fb_a, FB_LEN);
+        memcpy(fb_b, fb_a, FB_LEN);
+
+        epd_pack_rgb565_rect(src, fb_a, STRIDE, x1, y1, x2, y2, mode);
+        for (int y = y1; y <= y2; y++)
+        {
+            for (int x = x1; x <= x2; x++)
+            {
+                epd_pack_set_px(fb_b, STRIDE, x, y, src[(y - y1) * w + (x - x1)], mode);
+            }
+        }
+        TEST_ASSERT_EQUAL_MEMORY(fb_a, fb_b, FB_LEN);
+    }
+}
+
+/* 整屏 200x200: 直接置位 vs 写 RGB565 显存再打包; 显存本身还要多占 W*H*2 字节 */
+TEST(pack, bench_set_px_vs_rgb565) {
+    const int iters = 50;
+    host_fill_random((uint8_t *)src, W * H * 2);
+
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < iters; i++)
+    {
+        for (int y = 0; y < H; y++)
+        {
+            for (int x = 0; x < W; x++)
+            {
+                epd_pack_set_px(fb_b, STRIDE, x, y, src[y * W + x], EPD_PACK_LEGACY);
+            }
+        }
+    }
+    host_bench_report("set_px into 1bpp 200x200", esp_timer_get_time() - t0, iters, "frame");
+
+    static uint16_t vram[W * H] __attribute__((aligned(4)));
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < iters; i++)
+    {
+        for (int p = 0; p < W * H; p++)
+        {
+            vram[p] = src[p];
+        }
+        epd_pack_rgb565_rect(vram, fb_a, STRIDE, 0, 0, W - 1, H - 1, EPD_PACK_LEGACY);
+    }
+    host_bench_report("rgb565 vram + pack 200x200", esp_timer_get_time() - t0, iters, "frame");
+    printf("BENCH draw buffer bytes: 1bpp %d, rgb565 %d\n", FB_LEN, W * H * 2);
+    TEST_ASSERT_EQUAL_MEMORY(fb_a, fb_b, FB_LEN);
+}
+
+/* 原来的逐像素路径 (EPD_DrawColorPixel): 0x7fff 及以上为白, 其余为黑 */
+static void ref_pack_legacy(const uint16_t *s, uint8_t *fb, int x1, int y1, int x2, int y2) {
+    for (int y = y1; y <= y2; y++)
+    {
+        for (int x = x1; x <= x2; x++, s++)
+        {
+            uint8_t *p = fb + y * STRIDE + (x >> 3);
+            const uint8_t bit = 0x80 >> (x & 0x07);
+            *p = (*s >= 0x7fff) ? (*p | bit) : (*p & ~bit);
+        }
+    }
+}
+
+/* 字宽内核对齐和不对齐 (src 偏 2 字节, 走逐字节分支) 的源数据都与逐像素路径逐位相同, 尾部字节只改覆盖到的位 */
+TEST(pack, legacy_kernel_matches_per_pixel) {
+    for (int iter = 0; iter < 400; iter++)
+    {
+        const uint16_t *s = src + (iter & 1);
+        int x1, y1, x2, y2;
+        random_rect(&x1, &y1, &x2, &y2);
+        const int n = (x2 - x1 + 1) * (y2 - y1 + 1);
+        host_fill_random((uint8_t *)src, (n + 1) * 2);
+        /* 边界值: 0x7ffe 为黑, 0x7fff/0x8000 为白 */
+        static const uint16_t edge[] = {0x7ffe, 0x7fff, 0x8000, 0x0000, 0xffff};
+        for (int k = 0; k < 5 && k < n; k++)
+        {
+            src[(iter & 1) + host_rand() % n] = edge[k];
+        }
+        host_fill_random(fb_a, FB_LEN);
+        memcpy(fb_b, fb_a, FB_LEN);
+
+        epd_pack_rgb565_rect(s, fb_a, STRIDE, x1, y1, x2, y2, EPD_PACK_LEGACY);
+        ref_pack_legacy(s, fb_b, x1, y1, x2, y2);
+        TEST_ASSERT_EQUAL_MEMORY(fb_b, fb_a, FB_LEN);
+    }
+}
+
+TEST(pack, bench_legacy_kernel) {
+    const int iters = 200;
+    host_fill_random((uint8_t *)src, sizeof(src));
+
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < iters; i++)
+    {
+        ref_pack_legacy(src, fb_b, 0, 0, W - 1, H - 1);
+    }
+    host_bench_report("legacy per pixel 200x200", esp_timer_get_time() - t0, iters, "frame");
+
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < iters; i++)
+    {
+        epd_pack_rgb565_rect(src, fb_a, STRIDE, 0, 0, W - 1, H - 1, EPD_PACK_LEGACY);
+    }
+    host_bench_report("legacy kernel aligned 200x200", esp_timer_get_time() - t0, iters, "frame");
+    TEST_ASSERT_EQUAL_MEMORY(fb_b, fb_a, FB_LEN);
+
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < iters; i++)
+    {
+        epd_pack_rgb565_rect(src + 1, fb_a, STRIDE, 0, 0, W - 1, H - 1, EPD_PACK_LEGACY);
+    }
+    host_bench_report("legacy kernel unaligned 200x200", esp_timer_get_time() - t0, iters, "frame");
+}
+
+/* 逐像素参考: 每个像素按屏幕坐标单独调用 epd_pack_is_white */
+static void ref_pack(const uint16_t *s, uint8_t *fb, int x1, int y1, int x2, int y2, epd_pack_mode_t mode) {
+    for (int y = y1; y <= y2; y++)
+    {
+        for (int x = x1; x <= x2; x++, s++)
+        {
+            epd_pack_set_px(fb, STRIDE, x, y, *s, mode);
+        }
+    }
+}
+
+/* 亮度和抖动按整字节查阈值表, 与逐像素判断逐位相同; 先扫一遍全部 65536 种颜色, 再用随机矩形覆盖尾部和不对齐的源 */
+TEST(pack, luma_dither_match_is_white) {
+    for (int m = EPD_PACK_LUMA; m <= EPD_PACK_DITHER; m++)
+    {
+        const epd_pack_mode_t mode = (epd_pack_mode_t)m;
+        for (int c0 = 0; c0 < 0x10000; c0 += W)
+        {
+            for (int k = 0; k < W; k++)
+            {
+                src[k] = (uint16_t)(c0 + k);
+            }
+            const int y = (c0 / W) % H;
+            memset(fb_a, 0x5a, FB_LEN);
+            memset(fb_b, 0x5a, FB_LEN);
+            epd_pack_rgb565_rect(src, fb_a, STRIDE, 0, y, W - 1, y, mode);
+            ref_pack(src, fb_b, 0, y, W - 1, y, mode);
+            TEST_ASSERT_EQUAL_MEMORY(fb_b, fb_a, FB_LEN);
+        }
+        for (int iter = 0; iter < 200; iter++)
+        {
+            const uint16_t *s = src + (iter & 1);
+            int x1, y1, x2, y2;
+            random_rect(&x1, &y1, &x2, &y2);
+            host_fill_random((uint8_t *)src, ((x2 - x1 + 1) * (y2 - y1 + 1) + 1) * 2);
+            host_fill_random(fb_a, FB_LEN);
+            memcpy(fb_b, fb_a, FB_LEN);
+            epd_pack_rgb565_rect(s, fb_a, STRIDE, x1, y1, x2, y2, mode);
+            ref_pack(s, fb_b, x1, y1, x2, y2, mode);
+            TEST_ASSERT_EQUAL_MEMORY(fb_b, fb_a, FB_LEN);
+        }
+    }
+}
+
+/* 驱动按区域把每行切段整字节打包, 结果与逐像素查 EPD_GetPackMode 相同; run_end 内模式不变 */
+TEST(pack, draw_area_follows_regions) {
+    epaper_emulator emu(W, H);
+    epaper_driver_display *drv = new epaper_driver_display(&emu);
+    drv->EPD_SetPackMode(EPD_PACK_LUMA);
+    TEST_ASSERT_TRUE(drv->EPD_AddPackRegion(20, 30, 101, 90, EPD_PACK_DITHER));
+    TEST_ASSERT_TRUE(drv->EPD_AddPackRegion(60, 50, 170, 140, EPD_PACK_LEGACY));     //与上一个重叠, 重叠部分仍为抖动
+    TEST_ASSERT_TRUE(drv->EPD_AddPackRegion(140, 0, 199, 199, EPD_PACK_DITHER));
+
+    for (int y = 0; y < H; y++)
+    {
+        int x = 0;
+        while (x < W)
+        {
+            uint16_t end;
+            const epd_pack_mode_t mode = drv->EPD_GetPackMode(x, y, &end);
+            TEST_ASSERT_TRUE(end >= x && end < W);
+            for (int k = x; k <= end; k++)
+            {
+                TEST_ASSERT_EQUAL(mode, drv->EPD_GetPackMode(k, y));
+            }
+            x = end + 1;
+        }
+    }
+
+    uint8_t *fb = drv->EPD_GetFrameBuffer();
+    for (int iter = 0; iter < 200; iter++)
+    {
+        int x1, y1, x2, y2;
+        random_rect(&x1, &y1, &x2, &y2);
+        host_fill_random((uint8_t *)src, (x2 - x1 + 1) * (y2 - y1 + 1) * 2);
+        host_fill_random(fb, FB_LEN);
+        memcpy(fb_b, fb, FB_LEN);
+        drv->EPD_DrawRGB565Area(x1, y1, x2, y2, src);
+        const uint16_t *s = src;
+        for (int y = y1; y <= y2; y++)
+        {
+            for (int x = x1; x <= x2; x++, s++)
+            {
+                epd_pack_set_px(fb_b, STRIDE, x, y, *s, drv->EPD_GetPackMode(x, y));
+            }
+        }
+        TEST_ASSERT_EQUAL_MEMORY(fb_b, fb, FB_LEN);
+    }
+    delete drv;
+}
+
+TEST(pack, bench_modes) {
+    static const char *names[] = {"pack legacy 200x200", "pack luma 200x200", "pack dither 200x200"};
+    const int iters = 200;
+    host_fill_random((uint8_t *)src, sizeof(src));
+    for (int m = 0; m < 3; m++)
+    {
+        int64_t t0 = esp_timer_get_time();
+        for (int i = 0; i < iters; i++)
+        {
+            epd_pack_rgb565_rect(src, fb_a, STRIDE, 0, 0, W - 1, H - 1, modes[m]);
+        }
+        host_bench_report(names[m], esp_timer_get_time() - t0, iters, "frame");
+    }
+
+    /* 三个区域时驱动按段打包 vs 每像素查一次区域 */
+    epaper_emulator emu(W, H);
+    epaper_driver_display *drv = new epaper_driver_display(&emu);
+    drv->EPD_SetPackMode(EPD_PACK_LUMA);
+    drv->EPD_AddPackRegion(20, 30, 101, 90, EPD_PACK_DITHER);
+    drv->EPD_AddPackRegion(60, 50, 170, 140, EPD_PACK_LEGACY);
+    drv->EPD_AddPackRegion(140, 0, 199, 199, EPD_PACK_DITHER);
+    int64_t t0 = esp_timer_get_time();
+    for (int i = 0; i < iters; i++)
+    {
+        drv->EPD_DrawRGB565Area(0, 0, W - 1, H - 1, src);
+    }
+    host_bench_report("draw area, 3 regions", esp_timer_get_time() - t0, iters, "frame");
+
+    t0 = esp_timer_get_time();
+    for (int i = 0; i < iters; i++)
+    {
+        const uint16_t *s = src;
+        for (int y = 0; y < H; y++)
+        {
+            for (int x = 0; x < W; x++, s++)
+            {
+                epd_pack_set_px(fb_b, STRIDE, x, y, *s, drv->EPD_GetPackMode(x, y));
+            }
+        }
+    }
+    host_bench_report("per pixel mode lookup, 3 regions", esp_timer_get_time() - t0, iters, "frame");
+    TEST_ASSERT_EQUAL_MEMORY(fb_b, drv->EPD_GetFrameBuffer(), FB_LEN);
+    delete drv;
+}
+
+TEST_GROUP_RUNNER(pack) {
+    RUN_TEST_CASE(pack, set_px_matches_rgb565_pack);
+    RUN_TEST_CASE(pack, bench_set_px_vs_rgb565);
+    RUN_TEST_CASE(pack, legacy_kernel_matches_per_pixel);
+    RUN_TEST_CASE(pack, bench_legacy_kernel);
+    RUN_TEST_CASE(pack, luma_dither_match_is_white);
+    RUN_TEST_CASE(pack, draw_area_follows_regions);
+    RUN_TEST_CASE(pack, bench_modes);
+}
@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <string.h>
+#include "unity.h"
+#include "unity_fixture.h"
+#include "epaper_rotate.h"
+#include "epaper_driver_bsp.h"
+#include "epaper_emulator.h"
+#include "host_test.h"
+
+#define MAX_FB  (epd_panel_1in54::fb_bytes)
+
+static uint8_t lbuf[MAX_FB];
+static uint8_t fb_a[MAX_FB];
+static uint8_t fb_b[MAX_FB];
+static uint16_t src[epd_panel_1in54::width * epd_panel_1in54::height];
+
+static const char *orient_name[2][4] = {
+    {"rot 0", "rot 90", "rot 180", "rot 270"},
+    {"rot 0 mirror", "rot 90 mirror", "rot 180 mirror", "rot 270 mirror"},
+};
+
+/* 逐像素参考: 逻辑画面 (x1..x2, y1..y2) 内每个像素经 epd_orient_map 写到面板 */
+static void ref_blit(const epd_orient_t *o, const uint8_t *l, uint8_t *fb, int x1, int y1, int x2, int y2) {
+    for (int ly = y1; ly <= y2; ly++)
+    {
+        for (int lx = x1; lx <= x2; lx++)
+        {
+            int px, py;
+            epd_orient_map(o, lx, ly, &px, &py);
+            const uint8_t bit = 0x80 >> (px & 0x07);
+            uint8_t *d = fb + py * o->pstride + (px >> 3);
+            *d = ((l[ly * o->lstride + (lx >> 3)] << (lx & 0x07)) & 0x80) ? (*d | bit) : (*d & ~bit);
+        }
+    }
+}
+
+/* 面板宽高为 8 的倍数时整块搬运: X 总是扩到字节, 转置时 Y 也扩到 8 行 */
+static void blit_extent(const epd_orient_t *o, int *x1, int *y1, int *x2, int *y2) {
+    if ((o->pw | o->ph) & 0x07)
+    {
+        return;
+    }
+    *x1 &= ~7;
+    *x2 |= 7;
+    if (o->swap)
+    {
+        *y1 &= ~7;
+        *y2 |= 7;
+    }
+}
+
+static void check_blit(int pw, int ph) {
+    for (int mirror = 0; mirror < 2; mirror++)
+    {
+        for (int rot = EPD_ROT_0; rot <= EPD_ROT_270; rot++)
+        {
+            epd_orient_t o;
+            epd_orient_init(&o, pw, ph, (epd_rotation_t)rot, mirror);
+            const int fb_len = o.pstride * ph;
+            for (int iter = 0; iter < 100; iter++)
+            {
+                int x1 = host_rand() % o.lw, x2 = x1 + host_rand() % (o.lw - x1);
+                int y1 = host_rand() % o.lh, y2 = y1 + host_rand() % (o.lh - y1);
+                host_fill_random(lbuf, o.lstride * o.lh);
+                host_fill_random(fb_a, fb_len);
+                memcpy(fb_b, fb_a, fb_len);
+
+                epd_rotate_blit(&o, lbuf, fb_a, x1, y1, x2, y2);
+                blit_extent(&o, &x1, &y1, &x2, &y2);
+                ref_blit(&o, lbuf, fb_b, x1, y1, x2, y2);
+                TEST_ASSERT_EQUAL_MEMORY_MESSAGE(fb_b, fb_a, fb_len, orient_name[mirror][rot]);
+            }
+        }
+    }
+}
+
+TEST_GROUP(rotate);
+
+TEST_SETUP(rotate) {
+    host_srand(0x0e1e);
+}
+
+TEST_TEAR_DOWN(rotate) {
+}
+
+/* 转置/字节翻转的快速路径与逐像素映射逐位相同, 方形和非方形面板, 4 个方向 x 镜像 */
+TEST(rotate, blit_matches_orient_map) {
+    check_blit(200, 200);
+    check_blit(200, 96);
+}
+
+/* 宽高不是 8 的倍数时走逐像素路径, 只改矩形内的像素 */
+TEST(rotate, blit_unaligned_panel) {
+    check_blit(100, 60);
+}
+
+/* 驱动: 旋转后打包进逻辑画面再转写, 刷新到模拟器的 RAM 与逐像素映射整个逻辑画面的结果相同 */
+TEST(rotate, driver_draw_area_all_orientations) {
+    for (int mirror = 0; mirror < 2; mirror++)
+    {
+        for (int rot = EPD_ROT_0; rot <= EPD_ROT_270; rot++)
+        {
+            epaper_emulator emu(epd_panel_1in54::width, epd_panel_1in54::height);
+            epaper_driver_display *drv = new epaper_driver_display(&emu);
+            drv->EPD_Init();
+            drv->EPD_SetRotation((epd_rotation_t)rot, mirror);
+            drv->EPD_SetPackMode(EPD_PACK_LUMA);
+            const int lw = drv->EPD_GetWidth();
+            const int lh = drv->EPD_GetHeight();
+            for (int iter = 0; iter < 8; iter++)
+            {
+                int x1 = (host_rand() % lw) & ~7, x2 = x1 + host_rand() % (lw - x1);
+                int y1 = host_rand() % lh, y2 = y1 + host_rand() % (lh - y1);
+                host_fill_random((uint8_t *)src, (x2 - x1 + 1) * (y2 - y1 + 1) * 2);
+                drv->EPD_DrawRGB565Area(x1, y1, x2, y2, src);
+
+                /* 逻辑画面本身与逐像素二值化一致 */
+                const uint8_t *l = drv->EPD_GetFrameBuffer();
+                const uint16_t *s = src;
+                for (int y = y1; y <= y2; y++)
+                {
+                    for (int x = x1; x <= x2; x++, s++)
+                    {
+                        const bool white = (l[y * ((lw + 7) >> 3) + (x >> 3)] << (x & 0x07)) & 0x80;
+                        TEST_ASSERT_EQUAL(epd_pack_is_white(*s, x, y, EPD_PACK_LUMA), white);
+                    }
+                }
+            }
+            drv->EPD_Display();
+
+            epd_orient_t o;
+            epd_orient_init(&o, epd_panel_1in54::width, epd_panel_1in54::height, (epd_rotation_t)rot, mirror);
+            memset(fb_b, 0, MAX_FB);
+            ref_blit(&o, drv->EPD_GetFrameBuffer(), fb_b, 0, 0, o.lw - 1, o.lh - 1);
+            TEST_ASSERT_TRUE(emu.read_ram(0x24, fb_a));
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(fb_b, fb_a, MAX_FB, orient_name[mirror][rot]);
+            delete drv;
+        }
+    }
+}
+
+TEST(rotate, bench_blit) {
+    const int iters = 200;
+    host_fill_random(lbuf, MAX_FB);
+    for (int mirror = 0; mirror < 2; mirror++)
+    {
+        for (int rot = EPD_ROT_0; rot <= EPD_ROT_270; rot++)
+        {
+            epd_orient_t o;
+            epd_orient_init(&o, epd_panel_1in54::width, epd_panel_1in54::height, (epd_rotation_t)rot, mirror);
+            char name[48];
+            int64_t t0 = esp_timer_get_time();
+            for (int i = 0; i < iters; i++)
+            {
+                epd_rotate_blit(&o, lbuf, fb_a, 0, 0, o.lw - 1, o.lh - 1);
+            }
+            snprintf(name, sizeof(name), "blit %s", orient_name[mirror][rot]);
+            host_bench_report(name, esp_timer_get_time() - t0, iters, "frame");
+
+            t0 = esp_timer_get_time();
+            for (int i = 0; i < iters; i++)
+            {
+                ref_blit(&o, lbuf, fb_b, 0, 0, o.lw - 1, o.lh - 1);
+            }
+            snprintf(name, sizeof(name), "per pixel %s", orient_name[mirror][rot]);
+            host_bench_report(name, esp_timer_get_time() - t0, iters, "frame");
+            TEST_ASSERT_EQUAL_MEMORY(fb_b, fb_a, MAX_FB);
+        }
+    }
+}
+
+TEST_GROUP_RUNNER(rotate) {
+    RUN_TEST_CASE(rotate, blit_matches_orient_map);
+    RUN_TEST_CASE(rotate, blit_unaligned_panel);
+    RUN_TEST_CASE(rotate, driver_draw_area_all_orientations);
+    RUN_TEST_CASE(rotate, bench_blit);
+}
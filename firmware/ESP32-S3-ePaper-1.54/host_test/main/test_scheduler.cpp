@@ -0,0 +1,184 @@
+#include <string.h>
+#include "unity.h"
+#include "unity_fixture.h"
+#include "epaper_refresh_scheduler.h"
+#include "epaper_driver_bsp.h"
+#include "epaper_emulator.h"
+#include "host_test.h"
+
+#define FB_LEN  (epaper_driver_display::Stride * epaper_driver_display::Height)
+
+/* 只启用 max_partials 的策略, 其余阈值按用例各自打开 */
+static epd_refresh_policy_t base_policy(void) {
+    epd_refresh_policy_t p = {};
+    p.max_partials = 10;
+    p.quiet_hour = -1;
+    p.defer_percent = 80;
+    p.partial_wf = EPD_WF_PARTIAL;
+    return p;
+}
+
+TEST_GROUP(scheduler);
+
+TEST_SETUP(scheduler) {
+}
+
+TEST_TEAR_DOWN(scheduler) {
+}
+
+TEST(scheduler, max_partials_forces_full) {
+    epaper_refresh_scheduler sched(base_policy());
+    for (int i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_EQUAL(EPD_WF_PARTIAL, sched.pick_waveform(EPD_UPDATE_NORMAL, 500));
+        sched.on_partial(500);
+    }
+    TEST_ASSERT_EQUAL(EPD_WF_FULL, sched.pick_waveform(EPD_UPDATE_NORMAL, 500));
+    TEST_ASSERT_EQUAL(EPD_WF_FULL, sched.pick_waveform(EPD_UPDATE_CAN_DEFER, 500));
+    TEST_ASSERT_EQUAL(EPD_WF_PARTIAL, sched.pick_waveform(EPD_UPDATE_URGENT_PARTIAL, 500));
+
+    sched.on_full();
+    epd_refresh_sched_stats_t st;
+    sched.get_stats(&st);
+    TEST_ASSERT_EQUAL(0, st.partials);
+    TEST_ASSERT_EQUAL(0, st.changed_px);
+    TEST_ASSERT_EQUAL(10, st.lifetime.partial_total);
+    TEST_ASSERT_EQUAL(1, st.lifetime.full_total);
+    TEST_ASSERT_EQUAL(5000, st.lifetime.changed_px_total);
+    TEST_ASSERT_EQUAL(EPD_WF_PARTIAL, sched.pick_waveform(EPD_UPDATE_NORMAL, 500));
+}
+
+/* CAN_DEFER 在阈值的 defer_percent% 时就顺便全刷, NORMAL 要等到 100% */
+TEST(scheduler, can_defer_goes_full_early) {
+    epaper_refresh_scheduler sched(base_policy());
+    for (int i = 0; i < 7; i++)
+    {
+        sched.on_partial(10);
+    }
+    TEST_ASSERT_FALSE(sched.full_due(EPD_UPDATE_CAN_DEFER));
+    sched.on_partial(10);
+    TEST_ASSERT_TRUE(sched.full_due(EPD_UPDATE_CAN_DEFER));
+    TEST_ASSERT_FALSE(sched.full_due(EPD_UPDATE_NORMAL));
+    TEST_ASSERT_FALSE(sched.full_due(EPD_UPDATE_URGENT_PARTIAL));
+}
+
+TEST(scheduler, changed_px_threshold) {
+    epd_refresh_policy_t p = base_policy();
+    p.max_partials = 0;
+    p.max_changed_px = 1000;
+    epaper_refresh_scheduler sched(p);
+    sched.on_partial(600);
+    TEST_ASSERT_FALSE(sched.full_due(EPD_UPDATE_NORMAL));
+    sched.on_partial(399);
+    TEST_ASSERT_FALSE(sched.full_due(EPD_UPDATE_NORMAL));
+    sched.on_partial(1);
+    TEST_ASSERT_TRUE(sched.full_due(EPD_UPDATE_NORMAL));
+}
+
+/* 小改动用快速波形, 但全刷到期时全刷优先 */
+TEST(scheduler, fast_partial_for_small_changes) {
+    epd_refresh_policy_t p = base_policy();
+    p.fast_max_px = 64;
+    epaper_refresh_scheduler sched(p);
+    TEST_ASSERT_EQUAL(EPD_WF_FAST_PARTIAL, sched.pick_waveform(EPD_UPDATE_NORMAL, 64));
+    TEST_ASSERT_EQUAL(EPD_WF_PARTIAL, sched.pick_waveform(EPD_UPDATE_NORMAL, 65));
+    for (int i = 0; i < 10; i++)
+    {
+        sched.on_partial(1);
+    }
+    TEST_ASSERT_EQUAL(EPD_WF_FULL, sched.pick_waveform(EPD_UPDATE_NORMAL, 1));
+    TEST_ASSERT_EQUAL(EPD_WF_FAST_PARTIAL, sched.pick_waveform(EPD_UPDATE_URGENT_PARTIAL, 1));
+}
+
+/* 接到驱动上: 第 max_partials+1 次窗口刷新在模拟器上变成全刷, 之后重新计数 */
+TEST(scheduler, driver_follows_policy) {
+    epd_refresh_policy_t p = base_policy();
+    p.max_partials = 2;
+    epaper_refresh_scheduler sched(p);
+    epaper_emulator emu(epaper_driver_display::Width, epaper_driver_display::Height);
+    epaper_driver_display *drv = new epaper_driver_display(&emu);
+    drv->EPD_SetScheduler(&sched);
+
+    host_srand(0x5c4e);
+    drv->EPD_Init();
+    drv->EPD_Clear();
+    drv->EPD_DisplayPartBaseImage();
+    drv->EPD_Init_Partial();
+
+    static const bool expect_partial[] = {true, true, false, true};
+    uint8_t *fb = drv->EPD_GetFrameBuffer();
+    for (int i = 0; i < 4; i++)
+    {
+        host_fill_random(fb + (20 + i * 30) * epaper_driver_display::Stride, epaper_driver_display::Stride);
+        drv->EPD_DisplayPartWindow(0, 0, epaper_driver_display::Width - 1, epaper_driver_display::Height - 1);
+        epd_emu_update_t up;
+        emu.get_last_update(&up);
+        TEST_ASSERT_EQUAL(expect_partial[i], up.partial);
+        TEST_ASSERT_EQUAL(0, up.stale_px);
+    }
+    epd_refresh_sched_stats_t st;
+    sched.get_stats(&st);
+    TEST_ASSERT_EQUAL(1, st.partials);
+    TEST_ASSERT_EQUAL(1, st.lifetime.full_total);
+
+    uint8_t ram[FB_LEN];
+    TEST_ASSERT_TRUE(emu.read_ram(0x26, ram));
+    TEST_ASSERT_EQUAL_MEMORY(fb, ram, FB_LEN);
+    delete drv;
+}
+
+/*
+ * 大面积改动在全刷到期时到来: 第二次的行段超过 DMA 暂存区剩余空间, 全刷的 EPD_Init 和整帧分配随后也会回绕,
+ * 行段不能放在暂存区里, 否则整帧拷贝会把它覆盖掉, 屏幕停在旧内容而 submitted 已是新内容.
+ */
+TEST(scheduler, driver_full_with_large_diff) {
+    epd_refresh_policy_t p = base_policy();
+    p.max_partials = 1;
+    epaper_refresh_scheduler sched(p);
+    epaper_emulator emu(epaper_driver_display::Width, epaper_driver_display::Height);
+    epaper_driver_display *drv = new epaper_driver_display(&emu);
+    drv->EPD_SetScheduler(&sched);
+
+    host_srand(0x1a5e);
+    drv->EPD_Init();
+    drv->EPD_Clear();
+    drv->EPD_DisplayPartBaseImage();
+    drv->EPD_Init_Partial();
+
+    static const int rows[2][2] = {{0, 120}, {40, 140}};
+    static const bool expect_partial[] = {true, false};
+    uint8_t *fb = drv->EPD_GetFrameBuffer();
+    uint8_t ram[FB_LEN];
+    for (int i = 0; i < 2; i++)
+    {
+        host_fill_random(fb + rows[i][0] * epaper_driver_display::Stride, rows[i][1] * epaper_driver_display::Stride);
+        drv->EPD_DisplayPartWindow(0, 0, epaper_driver_display::Width - 1, epaper_driver_display::Height - 1);
+        epd_emu_update_t up;
+        emu.get_last_update(&up);
+        TEST_ASSERT_EQUAL(expect_partial[i], up.partial);
+        TEST_ASSERT_TRUE(emu.read_ram(0x24, ram));
+        TEST_ASSERT_EQUAL_MEMORY(fb, ram, FB_LEN);
+        TEST_ASSERT_TRUE(emu.read_ram(0x26, ram));
+        TEST_ASSERT_EQUAL_MEMORY(fb, ram, FB_LEN);
+    }
+    TEST_ASSERT_TRUE(emu.read_ram(0, ram));
+    TEST_ASSERT_EQUAL_MEMORY(fb, ram, FB_LEN);
+
+    /* 内容未变, 不再刷新 */
+    epd_refresh_stats_t st;
+    drv->EPD_GetRefreshStats(&st);
+    const uint32_t issued = st.issued;
+    drv->EPD_DisplayPartWindow(0, 0, epaper_driver_display::Width - 1, epaper_driver_display::Height - 1);
+    drv->EPD_GetRefreshStats(&st);
+    TEST_ASSERT_EQUAL(issued, st.issued);
+    delete drv;
+}
+
+TEST_GROUP_RUNNER(scheduler) {
+    RUN_TEST_CASE(scheduler, max_partials_forces_full);
+    RUN_TEST_CASE(scheduler, can_defer_goes_full_early);
+    RUN_TEST_CASE(scheduler, changed_px_threshold);
+    RUN_TEST_CASE(scheduler, fast_partial_for_small_changes);
+    RUN_TEST_CASE(scheduler, driver_follows_policy);
+    RUN_TEST_CASE(scheduler, driver_full_with_large_diff);
+}
@@ -0,0 +1,103 @@
+#include <string.h>
+#include "unity.h"
+#include "unity_fixture.h"
+#include "epaper_driver_bsp.h"
+#include "epaper_emulator.h"
+#include "host_test.h"
+
+#define FB_LEN  (epaper_driver_display::Stride * epaper_driver_display::Height)
+
+/* 旧的发送方式: 每个字节一次阻塞传输 (SPI_SendByte), 用来和批量排队的传输对比 */
+class per_byte_transport : public epaper_transport {
+private:
+    epaper_transport *inner;
+
+public:
+    per_byte_transport(epaper_transport *t) : inner(t) {}
+
+    void queue(uint8_t dc_level, const uint8_t *data, int len) override {
+        for (int i = 0; i < len; i++)
+        {
+            inner->queue(dc_level, data + i, 1);
+        }
+    }
+    uint32_t fence(epd_spi_done_cb_t cb, void *arg) override { return inner->fence(cb, arg); }
+    void wait(uint32_t ticket) override { inner->wait(ticket); }
+    void set_rst(int level) override { inner->set_rst(level); }
+    void wait_busy() override { inner->wait_busy(); }
+    bool read(uint8_t cmd, uint8_t *data, int len) override { return inner->read(cmd, data, len); }
+    void delay_ms(uint32_t ms) override { inner->delay_ms(ms); }
+    void get_stats(epd_spi_stats_t *stats) override { inner->get_stats(stats); }
+};
+
+typedef struct {
+    epd_emu_stats_t total;
+    epd_emu_update_t full;
+    epd_emu_update_t partial;
+}xfer_run_t;
+
+static uint8_t screen[FB_LEN];
+
+/* 开机底图 + 一次时钟大小的局部刷新, 记录两次刷新各自的传输开销 */
+static void run_sequence(bool per_byte, xfer_run_t *out) {
+    epaper_emulator emu(epaper_driver_display::Width, epaper_driver_display::Height);
+    per_byte_transport pb(&emu);
+    epaper_driver_display *drv = new epaper_driver_display(per_byte ? (epaper_transport *)&pb : &emu);
+
+    host_srand(0x5eed);
+    drv->EPD_Init();
+    drv->EPD_Clear();
+    host_fill_random(drv->EPD_GetFrameBuffer(), FB_LEN);
+    drv->EPD_DisplayPartBaseImage();
+    emu.get_last_update(&out->full);
+    drv->EPD_Init_Partial();
+
+    uint8_t *fb = drv->EPD_GetFrameBuffer();
+    for (int y = 5; y < 21; y++)
+    {
+        host_fill_random(fb + y * epaper_driver_display::Stride, 12);
+    }
+    drv->EPD_DisplayPartWindow(0, 5, 95, 20);
+    emu.get_last_update(&out->partial);
+    emu.get_emu_stats(&out->total);
+    emu.read_ram(0, screen);
+    delete drv;
+}
+
+static void report(const char *name, const epd_emu_update_t *up) {
+    printf("BENCH %-32s %6lu B %6lu xfers %8llu us\n", name, (unsigned long)up->bytes,
+           (unsigned long)up->transactions, (unsigned long long)up->sim_us);
+}
+
+TEST_GROUP(transport);
+
+TEST_SETUP(transport) {
+}
+
+TEST_TEAR_DOWN(transport) {
+}
+
+/* 同样的命令流, 批量排队只是把字节合并成更少的传输, 屏幕结果必须逐位相同 */
+TEST(transport, bench_queued_vs_per_byte) {
+    static uint8_t queued_screen[FB_LEN];
+    xfer_run_t queued, per_byte;
+    run_sequence(false, &queued);
+    memcpy(queued_screen, screen, FB_LEN);
+    run_sequence(true, &per_byte);
+
+    TEST_ASSERT_EQUAL_MEMORY(screen, queued_screen, FB_LEN);
+    TEST_ASSERT_EQUAL(per_byte.total.bytes, queued.total.bytes);
+    TEST_ASSERT_EQUAL(per_byte.total.bytes, per_byte.total.transactions);
+    TEST_ASSERT_LESS_THAN(per_byte.full.transactions / 10, queued.full.transactions);
+    TEST_ASSERT_LESS_THAN(per_byte.partial.transactions / 4, queued.partial.transactions);
+    TEST_ASSERT_LESS_THAN(per_byte.partial.sim_us, queued.partial.sim_us);
+
+    report("spi base image, per byte", &per_byte.full);
+    report("spi base image, queued", &queued.full);
+    report("spi partial 96x16, per byte", &per_byte.partial);
+    report("spi partial 96x16, queued", &queued.partial);
+}
+
+TEST_GROUP_RUNNER(transport) {
+    RUN_TEST_CASE(transport, bench_queued_vs_per_byte);
+}
@@ -6,6 +6,7 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "esp_timer.h"
+#include "esp_pm.h"
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_system.h"
@@ -15,16 +16,21 @@
 #include "protocol_examples_common.h"
 #include "mqtt_client.h"
 #include "esp_sntp.h"
-#include "cJSON.h"
 
 // 硬件驱动引用 (厂商提供的驱动)
 #include "user_app.h"
 #include "user_config.h"
+#include "epaper_glyph.h"
+#include "epaper_glyph_cache.h"
+#include "clock_service.h"
+#include "task_model.h"
+#include "button_bsp.h"
 #include "lvgl.h"
 #include "driver/gpio.h" // 记得引入头文件
 
 static const char *TAG = "EPAPER_MAIN";
 static SemaphoreHandle_t lvgl_mux = NULL;
+static TaskHandle_t lvgl_task_handle = NULL;
 
 // ================== 配置区域 ==================
 // [请修改] 替换为你的 EMQX 服务器地址
@@ -42,11 +48,71 @@ extern "C" {
     LV_FONT_DECLARE(ui_font_FontCN16);
 }
 
+// 标签使用的中文字体, 开启字形缓存时换成包了一层缓存的副本
+static const lv_font_t *ui_font = &ui_font_FontCN16;
+
+#if EPD_GLYPH_CACHE
+// ================== 字形缓存 ==================
+// 中文字体为 2bpp, 每次渲染都要在稀疏的 cmap 里查字, 再逐像素混合后二值化.
+// 包一层字体: 字形第一次用到时二值化成 1bpp (不透明度过半为黑, 与 set_px_cb 一致) 按码位缓存, LRU 淘汰;
+// 之后的排版和绘制直接用缓存里的度量和位图, 同样的标题重复渲染几乎不再访问原字体.
+static epaper_glyph_cache *glyph_cache = NULL;
+static lv_font_t ui_font_cached;
+static const epd_glyph_slot_t *glyph_last = NULL;   // LVGL 取完字形描述后紧接着取同一个字的位图
+
+static bool cached_get_glyph_dsc(const lv_font_t *font, lv_font_glyph_dsc_t *dsc, uint32_t letter, uint32_t letter_next) {
+    const lv_font_t *base = (const lv_font_t *)font->user_data;
+    const epd_glyph_slot_t *s = glyph_cache->find(letter);
+    if (s == NULL) {
+        // 这个字体没有字距调整, 度量与 letter_next 无关, 可以按码位缓存
+        if (!base->get_glyph_dsc(base, dsc, letter, letter_next)) return false;
+        const uint8_t *bmp = (dsc->box_w && dsc->box_h) ? base->get_glyph_bitmap(base, letter) : NULL;
+        epd_glyph_metrics_t m = {dsc->adv_w, dsc->box_w, dsc->box_h, dsc->ofs_x, dsc->ofs_y};
+        s = glyph_cache->insert(letter, &m, bmp, dsc->bpp);
+        if (s == NULL) {
+            glyph_last = NULL;      // 放不进槽位, 这个字照常用原字体
+            return true;
+        }
+    }
+    dsc->adv_w = s->m.adv_w;
+    dsc->box_w = s->m.box_w;
+    dsc->box_h = s->m.box_h;
+    dsc->ofs_x = s->m.ofs_x;
+    dsc->ofs_y = s->m.ofs_y;
+    dsc->bpp = 1;
+    dsc->is_placeholder = 0;
+    glyph_last = s;
+    return true;
+}
+
+static const uint8_t *cached_get_glyph_bitmap(const lv_font_t *font, uint32_t letter) {
+    if (glyph_last && glyph_last->letter == letter) return glyph_last->bitmap;
+    const epd_glyph_slot_t *s = glyph_cache->peek(letter);
+    if (s) return s->bitmap;
+    const lv_font_t *base = (const lv_font_t *)font->user_data;
+    return base->get_glyph_bitmap(base, letter);
+}
+
+// 缓存分配失败时返回原字体
+static const lv_font_t *glyph_cache_wrap(const lv_font_t *base) {
+    glyph_cache = new epaper_glyph_cache(EPD_GLYPH_CACHE_SLOTS);
+    if (!glyph_cache->ready()) return base;
+    ui_font_cached = *base;
+    ui_font_cached.get_glyph_dsc = cached_get_glyph_dsc;
+    ui_font_cached.get_glyph_bitmap = cached_get_glyph_bitmap;
+    ui_font_cached.user_data = (void *)base;
+    return &ui_font_cached;
+}
+#endif
+
 // ================== 全局 UI 对象 ==================
 lv_obj_t *ui_time_label = NULL;
 lv_obj_t *ui_count_label = NULL;
 lv_obj_t *ui_tasks[3] = {NULL};
 lv_obj_t *ui_dates[3] = {NULL};
+#if EPD_PAGE_CACHE
+lv_obj_t *ui_page_label = NULL;     // 右下角页码 "当前/总数"
+#endif
 
 // ================== 1. 手写 UI 初始化函数 ==================
 void init_manual_ui(void) {
@@ -57,7 +123,7 @@ void init_manual_ui(void) {
     // 2. 顶部状态栏 - 时间
     ui_time_label = lv_label_create(scr);
     // 使用中文字体以支持可能的中文日期格式，且字体大小合适
-    lv_obj_set_style_text_font(ui_time_label, &ui_font_FontCN16, 0); 
+    lv_obj_set_style_text_font(ui_time_label, ui_font, 0); 
     lv_label_set_text(ui_time_label, "连接中...");
     lv_obj_set_style_text_color(ui_time_label, lv_color_black(), 0);
     // 调整位置，稍微留出边距
@@ -65,7 +131,7 @@ void init_manual_ui(void) {
 
     // 2. 顶部状态栏 - 计数
     ui_count_label = lv_label_create(scr);
-    lv_obj_set_style_text_font(ui_count_label, &ui_font_FontCN16, 0); 
+    lv_obj_set_style_text_font(ui_count_label, ui_font, 0); 
     lv_label_set_text(ui_count_label, "0");
     lv_obj_set_style_text_color(ui_count_label, lv_color_black(), 0);
     lv_obj_align(ui_count_label, LV_ALIGN_TOP_RIGHT, -5, 5);
@@ -86,7 +152,7 @@ void init_manual_ui(void) {
         lv_obj_set_style_text_color(ui_tasks[i], lv_color_black(), 0);
         
         // 【关键】设置中文字体，否则显示方框
-        lv_obj_set_style_text_font(ui_tasks[i], &ui_font_FontCN16, 0); 
+        lv_obj_set_style_text_font(ui_tasks[i], ui_font, 0); 
         
         lv_obj_align(ui_tasks[i], LV_ALIGN_TOP_LEFT, 5, 35 + (i * 55)); // 垂直间隔
         lv_label_set_text(ui_tasks[i], "等待数据...");
@@ -96,14 +162,107 @@ void init_manual_ui(void) {
         lv_obj_set_style_text_color(ui_dates[i], lv_color_black(), 0);
         
         // 【关键】设置中文字体
-        lv_obj_set_style_text_font(ui_dates[i], &ui_font_FontCN16, 0);
+        lv_obj_set_style_text_font(ui_dates[i], ui_font, 0);
         
         lv_obj_align(ui_dates[i], LV_ALIGN_TOP_LEFT, 5, 35 + (i * 55) + 20);
         lv_label_set_text(ui_dates[i], "--/-- --:--");
     }
+
+#if EPD_PAGE_CACHE
+    // 4. 页码 (只有一页时为空)
+    ui_page_label = lv_label_create(scr);
+    lv_obj_set_style_text_font(ui_page_label, ui_font, 0);
+    lv_obj_set_style_text_color(ui_page_label, lv_color_black(), 0);
+    lv_obj_align(ui_page_label, LV_ALIGN_BOTTOM_RIGHT, -5, -2);
+    lv_label_set_text(ui_page_label, "");
+#endif
+}
+
+// 图片和画布按 Bayer 抖动二值化, 文字和线条用 EPD_PACK_DEFAULT_MODE; 布局完成后调用
+// 当前界面只有文字, 不会登记任何区域, 驱动走单一模式的整块打包
+static void ui_register_pack_regions(lv_obj_t *parent) {
+    for (uint32_t i = 0; i < lv_obj_get_child_cnt(parent); i++) {
+        lv_obj_t *child = lv_obj_get_child(parent, i);
+        bool picture = lv_obj_check_type(child, &lv_img_class);
+#if LV_USE_CANVAS
+        picture = picture || lv_obj_check_type(child, &lv_canvas_class);
+#endif
+        if (!picture) {
+            ui_register_pack_regions(child);
+            continue;
+        }
+        lv_area_t a;
+        lv_obj_get_coords(child, &a);
+        if (a.x2 < 0 || a.y2 < 0) continue;     // 整个在屏幕外
+        if (!driver->EPD_AddPackRegion(LV_MAX(a.x1, 0), LV_MAX(a.y1, 0), a.x2, a.y2, EPD_PACK_DITHER)) {
+            ESP_LOGW(TAG, "pack region (%d,%d)-(%d,%d) not registered", a.x1, a.y1, a.x2, a.y2);
+        }
+    }
 }
 
 // ================== 2. 逻辑辅助函数 ==================
+// 更新来源及其能容忍的刷新延迟; LVGL 把同一轮的修改画在一起, flush 时按本轮最紧的来源提交刷新
+typedef enum {
+    UI_SRC_CLOCK = 0,
+    UI_SRC_TASKS,
+    UI_SRC_PAGE,
+    UI_SRC_COUNT,
+} ui_source_t;
+
+static const uint32_t ui_source_latency_ms[UI_SRC_COUNT] = {
+    EPD_LATENCY_CLOCK_MS,
+    EPD_LATENCY_TASKS_MS,
+    EPD_LATENCY_PAGE_MS,
+};
+
+static uint32_t ui_pending_latency_ms = EPD_LATENCY_ANY;
+static epd_refresh_cb_t ui_pending_cb = NULL;   // 本轮 flush 提交的刷新完成后回调 (开机计时用)
+static void *ui_pending_cb_arg = NULL;
+
+// 开机时间线 (esp_timer 启动后的毫秒数); 首屏指第一份任务列表 (缓存或实时) 刷新完成
+static int64_t boot_first_display_us = 0;
+static int64_t boot_first_live_us = 0;
+
+static void boot_mark(const char *stage) {
+    ESP_LOGI(TAG, "boot +%lld ms: %s", (long long)(esp_timer_get_time() / 1000), stage);
+}
+
+// 刷新任务中回调, arg 非空表示画的是开机读回的缓存快照
+static void boot_display_done(void *arg) {
+    const bool stale = arg != NULL;
+    const int64_t now = esp_timer_get_time();
+    if (boot_first_display_us == 0) {
+        boot_first_display_us = now;
+        boot_mark(stale ? "first meaningful display (cached tasks)" : "first meaningful display (live tasks)");
+    }
+    if (!stale && boot_first_live_us == 0) {
+        boot_first_live_us = now;
+        boot_mark("live tasks on screen");
+    }
+}
+
+// 渲染快照时调用 (持有 LVGL 锁), 实时列表上屏之前每次都挂上计时回调
+static void boot_profile_arm(const task_snapshot_t *snap) {
+    if (boot_first_live_us != 0) return;
+    ui_pending_cb = boot_display_done;
+    ui_pending_cb_arg = snap->stale ? (void *)1 : NULL;
+}
+
+// LVGL 空闲时暂停了刷新定时器, 有修改时恢复它并唤醒 LVGL 任务
+static void lvgl_wake(void) {
+    lv_disp_t *disp = lv_disp_get_default();
+    if (disp && disp->refr_timer) lv_timer_resume(disp->refr_timer);
+    if (lvgl_task_handle) xTaskNotifyGive(lvgl_task_handle);
+}
+
+// 修改 LVGL 对象后调用 (持有 LVGL 锁)
+static void ui_mark_source(ui_source_t src) {
+    if (ui_source_latency_ms[src] < ui_pending_latency_ms) {
+        ui_pending_latency_ms = ui_source_latency_ms[src];
+    }
+    lvgl_wake();
+}
+
 static bool example_lvgl_lock(int timeout_ms) {
     const TickType_t timeout_ticks = (timeout_ms == -1) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
     return xSemaphoreTake(lvgl_mux, timeout_ticks) == pdTRUE;       
@@ -113,6 +272,52 @@ static void example_lvgl_unlock(void) {
     xSemaphoreGive(lvgl_mux);
 }
 
+// UI 批量更新: ui_begin() 到 ui_commit() 之间持有 LVGL 锁, LVGL 任务不会渲染到一半的列表;
+// 只有文字真正变化的标签才会被 invalidate, commit 时有变化才唤醒 LVGL, 整批修改在同一轮渲染和 flush 中完成
+typedef struct {
+    uint32_t batches;
+    uint32_t empty_batches;     // 没有标签变化, 不触发渲染
+    uint32_t labels_set;
+    uint32_t labels_skipped;    // 文字与当前相同
+} ui_batch_stats_t;
+
+static ui_batch_stats_t ui_batch_stats;
+static int ui_batch_changed = 0;
+
+static bool ui_begin(void) {
+    if (!example_lvgl_lock(-1)) return false;
+    ui_batch_changed = 0;
+    return true;
+}
+
+static void ui_set_text(lv_obj_t *label, const char *text) {
+    if (label == NULL) return;
+    if (strcmp(lv_label_get_text(label), text) == 0) {
+        ui_batch_stats.labels_skipped++;
+        return;
+    }
+    lv_label_set_text(label, text);
+    ui_batch_stats.labels_set++;
+    ui_batch_changed++;
+}
+
+static void ui_commit(ui_source_t src) {
+    ui_batch_stats.batches++;
+    if (ui_batch_changed) {
+        ui_mark_source(src);
+    } else {
+        ui_batch_stats.empty_batches++;
+    }
+    ESP_LOGD(TAG, "ui batch: %d changed, total %lu set / %lu skipped", ui_batch_changed,
+             (unsigned long)ui_batch_stats.labels_set, (unsigned long)ui_batch_stats.labels_skipped);
+    example_lvgl_unlock();
+}
+
+// 开机读回的缓存快照在计数后标 "(旧)", 实时消息到达后去掉
+static void format_count(const task_snapshot_t *snap, char *buf, size_t size) {
+    snprintf(buf, size, snap->stale ? "待办: %d (旧)" : "待办: %d", snap->total);
+}
+
 void format_timestamp(time_t raw_time, char* buffer, size_t size) {
     if (raw_time == 0) {
         snprintf(buffer, size, "无截止");
@@ -125,59 +330,453 @@ void format_timestamp(time_t raw_time, char* buffer, size_t size) {
 }
 
 // ================== 3. UI 更新逻辑 ==================
-void update_ui_from_json(cJSON *root) {
-    if (example_lvgl_lock(-1)) {
-        if (cJSON_IsArray(root)) {
-            int total = cJSON_GetArraySize(root);
-            
-            // 更新总数
-            if(ui_count_label) {
-                char buf[32];
-                sprintf(buf, "待办: %d", total);
-                lv_label_set_text(ui_count_label, buf);
+// MQTT 任务只负责解码, 快照经 "最新者胜" 邮箱交给视图任务; 渲染和墨水屏刷新再慢也不会堵住 MQTT 的收包和心跳
+static task_mailbox_t *ui_mailbox = NULL;
+
+#if EPD_PAGE_CACHE
+static bool page_cache_render(const task_snapshot_t *snap);
+#endif
+
+// 把一份任务快照画到 UI 上 (视图任务中)
+static void render_snapshot(const task_snapshot_t *snap) {
+#if EPD_PAGE_CACHE
+    // 翻页缓存可用时预渲染所有页面, 否则只显示前三个任务
+    if (page_cache_render(snap)) return;
+#endif
+    if (ui_begin()) {
+        // 更新总数
+        char buf[32];
+        format_count(snap, buf, sizeof(buf));
+        ui_set_text(ui_count_label, buf);
+
+        // 更新列表
+        for(int i=0; i<3; i++) {
+            if (i < snap->count) {
+                const task_entry_t *e = &snap->items[i];
+                char due_str[32];
+                format_timestamp((time_t)(e->due_ms/1000), due_str, 32);
+                ui_set_text(ui_tasks[i], e->summary);
+                ui_set_text(ui_dates[i], due_str);
+            } else {
+                ui_set_text(ui_tasks[i], "");
+                ui_set_text(ui_dates[i], "");
             }
+        }
+        boot_profile_arm(snap);
+        ui_commit(UI_SRC_TASKS);
+    }
+}
 
-            // 更新列表
-            for(int i=0; i<3; i++) {
-                if (i < total) {
-                    cJSON *item = cJSON_GetArrayItem(root, i);
-                    cJSON *summary = cJSON_GetObjectItem(item, "summary");
-                    cJSON *due = cJSON_GetObjectItem(item, "dueTimestamp");
-                    
-                    char due_str[32];
-                    long long ts = 0;
-                    if (due) {
-                        ts = cJSON_IsString(due) ? atoll(due->valuestring) : (long long)due->valuedouble;
-                    }
-                    format_timestamp((time_t)(ts/1000), due_str, 32);
-
-                    if(ui_tasks[i]) lv_label_set_text(ui_tasks[i], summary ? summary->valuestring : "");
-                    if(ui_dates[i]) lv_label_set_text(ui_dates[i], due_str);
-                } else {
-                    if(ui_tasks[i]) lv_label_set_text(ui_tasks[i], "");
-                    if(ui_dates[i]) lv_label_set_text(ui_dates[i], "");
-                }
-            }
+// 视图任务: 只渲染邮箱里最新的快照, 渲染期间到达的中间快照被覆盖丢弃
+static void ui_view_task(void *arg) {
+    static task_snapshot_t snap;
+    task_mailbox_stats_t stats;
+    for (;;) {
+        if (!task_mailbox_take(ui_mailbox, &snap, portMAX_DELAY)) continue;
+        render_snapshot(&snap);
+        // 实时列表存进 NVS, 下次开机先显示它
+        if (!snap.stale) task_snapshot_store_save(&snap);
+        task_mailbox_get_stats(ui_mailbox, &stats);
+        ESP_LOGI(TAG, "snapshot %lu rendered: queued %lu us (max %lu), %lu dropped",
+                 (unsigned long)snap.seq, (unsigned long)stats.last_latency_us,
+                 (unsigned long)stats.max_latency_us, (unsigned long)stats.dropped);
+#if EPD_GLYPH_CACHE
+        if (glyph_cache->ready()) {
+            epd_glyph_cache_stats_t gs;
+            glyph_cache->get_stats(&gs);
+            ESP_LOGI(TAG, "glyph cache: %lu hits, %lu misses, %lu evicted, %lu/%d slots",
+                     (unsigned long)gs.hits, (unsigned long)gs.misses, (unsigned long)gs.evictions,
+                     (unsigned long)gs.used, EPD_GLYPH_CACHE_SLOTS);
         }
-        example_lvgl_unlock();
+#endif
     }
 }
 
 // ================== 4. MQTT & Time & Drivers ==================
 
-// 驱动刷新回调 (保留原厂逻辑，适配墨水屏)
+// 本轮渲染累积的脏区域 (LVGL 可能分多次调用 flush_cb)
+static lv_area_t epd_dirty_area;
+static bool epd_dirty_valid = false;
+
+// 墨水屏按字节 (8 像素) 寻址，把无效区域的 X 方向扩展到字节边界
+static void example_lvgl_rounder_cb(lv_disp_drv_t *drv, lv_area_t *area) {
+    area->x1 &= ~0x07;
+    area->x2 |= 0x07;
+}
+
+#if EPD_LVGL_RENDER_1BPP
+static int epd_draw_stride;     // 逻辑画面每行字节数, 旋转 90/270 时随逻辑宽度变化
+// 当前行上二值化方式相同的一段 [x1, x2], 只在像素离开这段时才向驱动查询; 每次 flush 后作废
+static int px_run_y = -1;
+static int px_run_x1, px_run_x2;
+static epd_pack_mode_t px_run_mode;
+
+// LVGL 的绘制缓冲就是驱动的 1bpp 帧缓冲, x/y 相对本次绘制区域, 直接置位, 不再需要 RGB565 显存和转换
+static void example_lvgl_set_px_cb(lv_disp_drv_t *drv, uint8_t *buf, lv_coord_t buf_w, lv_coord_t x, lv_coord_t y,
+                                   lv_color_t color, lv_opa_t opa) {
+    // 不足一半不透明度时保留原像素, 与先混合再二值化的结果一致
+    if (opa < LV_OPA_50) {
+        return;
+    }
+    const lv_area_t *area = drv->draw_ctx->buf_area;
+    const int px = area->x1 + x;
+    const int py = area->y1 + y;
+    if (py != px_run_y || px < px_run_x1 || px > px_run_x2) {
+        uint16_t end;
+        px_run_mode = driver->EPD_GetPackMode(px, py, &end);
+        px_run_y = py;
+        px_run_x1 = px;
+        px_run_x2 = end;
+    }
+    epd_pack_set_px(buf, epd_draw_stride, px, py, color.full, px_run_mode);
+}
+#endif
+
+#if EPD_CLOCK_FAST_PATH
+// ================== 时钟快速路径 ==================
+// 每分钟只有 "MM-DD HH:MM" 的几个数字在变: 用预先二值化的数字字形直接画进帧缓冲再局部刷新, 不走 LVGL 渲染.
+// LVGL 仍负责布局: ui_time_label 保留位置, 文字设为透明; LVGL 重绘到这块区域时在 flush 回调里补画.
+typedef struct {
+    uint32_t ticks;
+    uint32_t last_cpu_us;       // 画字 + 转写 + 提交刷新请求
+    uint32_t max_cpu_us;
+    uint32_t last_spi_bytes;    // 本次刷新 (可能与同时到达的其它区域合并) 发出的 SPI 字节
+    uint64_t total_spi_bytes;
+} clock_fast_stats_t;
+
+static epd_glyph_set_t clock_glyphs;
+static epd_window_t clock_win;          // 逻辑坐标, X 已按字节对齐, 覆盖最宽的日期时间
+static int clock_x, clock_y;            // 文字行左上角
+static char clock_text[16];
+static bool clock_active = false;
+static clock_fast_stats_t clock_stats;
+static epd_spi_stats_t clock_spi_start;
+
+// 从 LVGL 字体中取出时钟用到的字符, 按 set_px_cb 同样的规则 (不透明度过半为黑) 二值化
+static void clock_glyphs_init(const lv_font_t *font) {
+    epd_glyph_set_init(&clock_glyphs, lv_font_get_line_height(font), font->base_line);
+    for (const char *p = "0123456789-: "; *p; p++) {
+        lv_font_glyph_dsc_t g;
+        if (!lv_font_get_glyph_dsc(font, &g, *p, 0)) continue;
+        const uint8_t *bmp = lv_font_get_glyph_bitmap(font, *p);
+        if (g.box_w && bmp == NULL) continue;
+        if (!epd_glyph_add(&clock_glyphs, *p, g.box_w, g.box_h, g.ofs_x, g.ofs_y, g.adv_w, bmp, g.bpp)) {
+            ESP_LOGW(TAG, "clock glyph '%c' dropped", *p);
+        }
+    }
+}
+
+static void clock_draw(void) {
+    const int stride = (driver->EPD_GetWidth() + 7) >> 3;
+    epd_text_draw(&clock_glyphs, driver->EPD_GetFrameBuffer(), stride, &clock_win, clock_x, clock_y, clock_text);
+    driver->EPD_CommitArea(clock_win.x1, clock_win.y1, clock_win.x2, clock_win.y2);
+}
+
+static bool clock_overlaps(const lv_area_t *area) {
+    return clock_active && area->x1 <= clock_win.x2 && area->x2 >= clock_win.x1 &&
+           area->y1 <= clock_win.y2 && area->y2 >= clock_win.y1;
+}
+
+// 第一次走 LVGL: 定下标签位置并把文字改为透明, 之后这块区域归快速路径 (调用方持有 LVGL 锁)
+static void clock_activate(const char *text) {
+    lv_label_set_text(ui_time_label, text);
+    lv_obj_set_style_text_opa(ui_time_label, LV_OPA_TRANSP, 0);
+    lv_obj_update_layout(ui_time_label);
+    lv_area_t a;
+    lv_obj_get_content_coords(ui_time_label, &a);
+
+    int digit_w = 0;
+    for (char d = '0'; d <= '9'; d++) {
+        const char s[2] = {d, 0};
+        const int w = epd_text_width(&clock_glyphs, s);
+        if (w > digit_w) digit_w = w;
+    }
+    const int max_w = 8 * digit_w + epd_text_width(&clock_glyphs, "- :");
+    const int x2 = LV_MAX(a.x2, a.x1 + max_w - 1);
+    clock_x = a.x1;
+    clock_y = a.y1;
+    clock_win.x1 = a.x1 & ~0x07;
+    clock_win.x2 = LV_MIN(x2 | 0x07, driver->EPD_GetWidth() - 1);
+    clock_win.y1 = a.y1;
+    clock_win.y2 = LV_MIN(a.y1 + clock_glyphs.line_height - 1, driver->EPD_GetHeight() - 1);
+    snprintf(clock_text, sizeof(clock_text), "%s", text);
+    clock_active = true;
+}
+
+static void clock_refresh_done(void *arg) {
+    epd_spi_stats_t spi;
+    driver->EPD_GetSpiStats(&spi);
+    clock_stats.last_spi_bytes = spi.bytes - clock_spi_start.bytes;
+    clock_stats.total_spi_bytes += clock_stats.last_spi_bytes;
+    ESP_LOGI(TAG, "clock tick %lu: cpu %lu us (max %lu), spi %lu B",
+             (unsigned long)clock_stats.ticks, (unsigned long)clock_stats.last_cpu_us,
+             (unsigned long)clock_stats.max_cpu_us, (unsigned long)clock_stats.last_spi_bytes);
+}
+
+// 分钟变化时由时间任务调用, 只占用 LVGL 锁保护帧缓冲, 不触发 LVGL 渲染
+static void clock_fast_update(const char *text) {
+    if (strcmp(text, clock_text) == 0) return;
+    if (!example_lvgl_lock(-1)) return;
+    const int64_t t0 = esp_timer_get_time();
+    snprintf(clock_text, sizeof(clock_text), "%s", text);
+    clock_draw();
+    driver->EPD_GetSpiStats(&clock_spi_start);
+    clock_stats.ticks++;
+    driver->EPD_RefreshAsync(clock_win.x1, clock_win.y1, clock_win.x2, clock_win.y2, clock_refresh_done, NULL,
+                             EPD_UPDATE_CAN_DEFER, ui_source_latency_ms[UI_SRC_CLOCK]);
+    clock_stats.last_cpu_us = esp_timer_get_time() - t0;
+    if (clock_stats.last_cpu_us > clock_stats.max_cpu_us) clock_stats.max_cpu_us = clock_stats.last_cpu_us;
+    example_lvgl_unlock();
+}
+#endif
+
+#if EPD_PAGE_CACHE
+#if !EPD_LVGL_RENDER_1BPP
+#error "EPD_PAGE_CACHE needs EPD_LVGL_RENDER_1BPP (pages are captured from the 1bpp draw buffer)"
+#endif
+// ================== 翻页缓存 ==================
+// 任务多于三个时用按键翻页. 快照到达时把每一页预先渲染成一帧 1bpp 画面 (5000 字节) 存在 PSRAM,
+// 翻页只把该页的列表区域拷回帧缓冲再局部刷新, 按键路径上没有 LVGL 布局和文字渲染.
+// 有缓存后列表标签一直隐藏, LVGL 重绘到列表区域时在 flush 回调里补上当前页.
+#define PAGE_TASKS  3
+#define PAGE_MAX    ((TASK_MODEL_MAX_TASKS + PAGE_TASKS - 1) / PAGE_TASKS)
+
+typedef struct {
+    uint32_t renders;
+    uint32_t last_render_us;    // 预渲染一份快照的全部页面
+    uint32_t flips;
+    uint32_t last_cpu_us;       // 按键 -> 拷贝并提交刷新请求
+    uint32_t max_cpu_us;
+    uint32_t last_latency_us;   // 按键 -> 刷新完成, 新页面已在屏上
+    uint32_t max_latency_us;
+} page_stats_t;
+
+static uint8_t *page_cache = NULL;      // PAGE_MAX 帧, 每帧与逻辑画面的帧缓冲同样大小
+static uint8_t *page_scratch = NULL;    // 预渲染时替换 LVGL 的绘制缓冲, 不改动屏上的帧缓冲
+static size_t page_len;
+static epd_window_t page_win;           // 列表区域 (逻辑坐标, 整行)
+static int page_count = 0;              // 0: 还没有快照, 标签按原样显示
+static int page_cur = 0;
+static bool page_capturing = false;
+static int64_t page_flip_start_us;
+static page_stats_t page_stats;
+
+// 在 UI 建好之后调用 (持有 LVGL 锁)
+static bool page_cache_init(void) {
+    page_len = (size_t)epd_draw_stride * driver->EPD_GetHeight();
+    page_cache = (uint8_t *)heap_caps_malloc(PAGE_MAX * page_len, MALLOC_CAP_SPIRAM);
+    page_scratch = (uint8_t *)heap_caps_malloc(page_len, MALLOC_CAP_SPIRAM);
+    if (page_cache == NULL || page_scratch == NULL) {
+        ESP_LOGW(TAG, "page cache unavailable, showing first %d tasks only", PAGE_TASKS);
+        heap_caps_free(page_cache);
+        heap_caps_free(page_scratch);
+        page_cache = page_scratch = NULL;
+        return false;
+    }
+    lv_area_t a;
+    lv_obj_update_layout(ui_tasks[0]);
+    lv_obj_get_coords(ui_tasks[0], &a);
+    page_win.x1 = 0;
+    page_win.y1 = a.y1;
+    page_win.x2 = driver->EPD_GetWidth() - 1;
+    page_win.y2 = driver->EPD_GetHeight() - 1;
+    return true;
+}
+
+static bool page_overlaps(const lv_area_t *area) {
+    return page_count > 0 && !page_capturing && area->y1 <= page_win.y2 && area->y2 >= page_win.y1;
+}
+
+// 把当前页的列表区域拷回帧缓冲 (持有 LVGL 锁)
+static void page_blit(void) {
+    const size_t ofs = (size_t)page_win.y1 * epd_draw_stride;
+    const size_t len = (size_t)(page_win.y2 - page_win.y1 + 1) * epd_draw_stride;
+    memcpy(driver->EPD_GetFrameBuffer() + ofs, page_cache + page_cur * page_len + ofs, len);
+    driver->EPD_CommitArea(page_win.x1, page_win.y1, page_win.x2, page_win.y2);
+}
+
+static void page_set_hidden(bool hidden) {
+    for (int i = 0; i < PAGE_TASKS; i++) {
+        if (hidden) {
+            lv_obj_add_flag(ui_tasks[i], LV_OBJ_FLAG_HIDDEN);
+            lv_obj_add_flag(ui_dates[i], LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_clear_flag(ui_tasks[i], LV_OBJ_FLAG_HIDDEN);
+            lv_obj_clear_flag(ui_dates[i], LV_OBJ_FLAG_HIDDEN);
+        }
+    }
+    if (hidden) {
+        lv_obj_add_flag(ui_page_label, LV_OBJ_FLAG_HIDDEN);
+    } else {
+        lv_obj_clear_flag(ui_page_label, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+static void page_fill(const task_snapshot_t *snap, int page, int pages) {
+    for (int i = 0; i < PAGE_TASKS; i++) {
+        const int idx = page * PAGE_TASKS + i;
+        if (idx < snap->count) {
+            const task_entry_t *e = &snap->items[idx];
+            char due_str[32];
+            format_timestamp((time_t)(e->due_ms/1000), due_str, 32);
+            lv_label_set_text(ui_tasks[i], e->summary);
+            lv_label_set_text(ui_dates[i], due_str);
+        } else {
+            lv_label_set_text(ui_tasks[i], "");
+            lv_label_set_text(ui_dates[i], "");
+        }
+    }
+    // 快照最多带 TASK_MODEL_MAX_TASKS 个任务, 服务器发来的更多时页码后注明只显示前几个
+    char buf[32];
+    if (snap->total > snap->count) {
+        snprintf(buf, sizeof(buf), "%d/%d (前%d)", page + 1, pages, snap->count);
+    } else {
+        snprintf(buf, sizeof(buf), "%d/%d", page + 1, pages);
+    }
+    lv_label_set_text(ui_page_label, pages > 1 ? buf : "");
+}
+
+// 预渲染快照的全部页面 (视图任务中); 缓存不可用时返回 false, 由调用方按三个槽位直接显示
+static bool page_cache_render(const task_snapshot_t *snap) {
+    if (page_cache == NULL) return false;
+    if (!example_lvgl_lock(-1)) return true;
+    const int64_t t0 = esp_timer_get_time();
+    lv_disp_t *disp = lv_disp_get_default();
+    lv_disp_draw_buf_t *draw_buf = disp->driver->draw_buf;
+    lv_area_t win = {(lv_coord_t)page_win.x1, (lv_coord_t)page_win.y1, (lv_coord_t)page_win.x2, (lv_coord_t)page_win.y2};
+
+    // 已有的待重绘区域 (如刚激活的时钟) 先画到屏上的帧缓冲, 不能被预渲染吞掉
+    if (disp->inv_p) lv_refr_now(disp);
+
+    // LVGL 只重绘无效区域, 草稿缓冲从当前画面开始, 每页把整个列表区域设为无效
+    const int pages = LV_MAX(1, (snap->count + PAGE_TASKS - 1) / PAGE_TASKS);
+    // 经 lv_disp_draw_buf_init 换成草稿缓冲, 不直接改 draw_buf 的字段; 结束后同样换回帧缓冲
+    const uint32_t draw_px = draw_buf->size;
+    memcpy(page_scratch, driver->EPD_GetFrameBuffer(), page_len);
+    lv_disp_draw_buf_init(draw_buf, page_scratch, NULL, draw_px);
+    page_capturing = true;
+    page_set_hidden(false);
+    for (int p = 0; p < pages; p++) {
+        page_fill(snap, p, pages);
+        lv_inv_area(disp, &win);
+        lv_refr_now(disp);
+        memcpy(page_cache + p * page_len, page_scratch, page_len);
+    }
+    lv_disp_draw_buf_init(draw_buf, driver->EPD_GetFrameBuffer(), NULL, draw_px);
+    page_capturing = false;
+
+    // 标签隐藏后列表区域由 flush 回调从缓存补画; 计数走正常的 LVGL 渲染
+    page_set_hidden(true);
+    lv_inv_area(disp, &win);
+    page_count = pages;
+    if (page_cur >= pages) page_cur = 0;
+    char buf[32];
+    format_count(snap, buf, sizeof(buf));
+    lv_label_set_text(ui_count_label, buf);
+    boot_profile_arm(snap);
+    ui_mark_source(UI_SRC_TASKS);
+
+    page_stats.renders++;
+    page_stats.last_render_us = esp_timer_get_time() - t0;
+    ESP_LOGI(TAG, "%d task(s) pre-rendered into %d page(s) in %lu us", snap->count, pages,
+             (unsigned long)page_stats.last_render_us);
+    example_lvgl_unlock();
+    return true;
+}
+
+static void page_flip_done(void *arg) {
+    page_stats.last_latency_us = esp_timer_get_time() - page_flip_start_us;
+    if (page_stats.last_latency_us > page_stats.max_latency_us) page_stats.max_latency_us = page_stats.last_latency_us;
+    ESP_LOGI(TAG, "page flip %lu: cpu %lu us (max %lu), on screen after %lu ms (max %lu)",
+             (unsigned long)page_stats.flips, (unsigned long)page_stats.last_cpu_us,
+             (unsigned long)page_stats.max_cpu_us, (unsigned long)(page_stats.last_latency_us / 1000),
+             (unsigned long)(page_stats.max_latency_us / 1000));
+}
+
+// 翻页: 拷贝缓存中的一页并立即局部刷新, 只占用 LVGL 锁保护帧缓冲
+static void page_flip(int step) {
+    const int64_t t0 = esp_timer_get_time();
+    if (!example_lvgl_lock(-1)) return;
+    if (page_count > 1) {
+        page_cur = (page_cur + step + page_count) % page_count;
+        page_blit();
+        page_flip_start_us = t0;
+        page_stats.flips++;
+        driver->EPD_RefreshAsync(page_win.x1, page_win.y1, page_win.x2, page_win.y2, page_flip_done, NULL,
+                                 EPD_UPDATE_URGENT_PARTIAL, ui_source_latency_ms[UI_SRC_PAGE]);
+        page_stats.last_cpu_us = esp_timer_get_time() - t0;
+        if (page_stats.last_cpu_us > page_stats.max_cpu_us) page_stats.max_cpu_us = page_stats.last_cpu_us;
+    }
+    example_lvgl_unlock();
+}
+
+// BOOT 单击下一页, PWR 单击上一页 (事件组由 button_bsp 的按键扫描置位)
+static void page_button_task(void *arg) {
+    EventGroupHandle_t group = (EventGroupHandle_t)arg;
+    const int step = (group == boot_groups) ? 1 : -1;
+    for (;;) {
+        EventBits_t bits = xEventGroupWaitBits(group, set_bit_button(0), pdTRUE, pdFALSE, portMAX_DELAY);
+        if (bits & set_bit_button(0)) page_flip(step);
+    }
+}
+#endif
+
+// 每轮渲染耗时和像素数, 打开 DEBUG 日志可对比两种渲染模式
+static void example_lvgl_monitor_cb(lv_disp_drv_t *drv, uint32_t time_ms, uint32_t px) {
+    ESP_LOGD(TAG, "render %lu px in %lu ms", (unsigned long)px, (unsigned long)time_ms);
+}
+
+// 驱动刷新回调: 只下发 LVGL 本轮实际重绘的区域
 static void example_lvgl_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_map) {
-    uint16_t *buffer = (uint16_t *)color_map;
-    driver->EPD_Clear(); // 墨水屏特性：先清空显存
-    for(int y = area->y1; y <= area->y2; y++) {
-        for(int x = area->x1; x <= area->x2; x++) {
-            // 简单的二值化处理: 大于阈值设为黑，否则白
-            uint8_t color = (*buffer < 0x7fff) ? DRIVER_COLOR_BLACK : DRIVER_COLOR_WHITE;
-            driver->EPD_DrawColorPixel(x,y,color);
-            buffer++;
+#if EPD_PAGE_CACHE
+    // 预渲染时画进草稿缓冲: 不转写, 不补画时钟, 不提交刷新, 屏上的帧缓冲保持不变
+    if (page_capturing) {
+        px_run_y = -1;
+        lv_disp_flush_ready(drv);
+        return;
+    }
+#endif
+#if !EPD_LVGL_RENDER_1BPP
+    // 按行整字节二值化打包进驱动帧缓冲 (rounder_cb 已保证 x1 按 8 对齐), 各区域按各自的二值化方式
+    driver->EPD_DrawRGB565Area(area->x1, area->y1, area->x2, area->y2, (const uint16_t *)color_map);
+#else
+    // 面板旋转安装时把逻辑画面的这块区域转写到面板帧缓冲, 不旋转时为空操作
+    driver->EPD_CommitArea(area->x1, area->y1, area->x2, area->y2);
+    px_run_y = -1;     // 区域可能在两轮渲染之间改变
+#endif
+#if EPD_CLOCK_FAST_PATH
+    // 时钟区域被 LVGL 画成了背景, 补画当前时间
+    if (clock_overlaps(area)) clock_draw();
+#endif
+#if EPD_PAGE_CACHE
+    // 列表区域被 LVGL 画成了背景, 补上当前页; 整个列表区域都要参与刷新
+    if (page_overlaps(area)) {
+        page_blit();
+        lv_area_t win = {(lv_coord_t)page_win.x1, (lv_coord_t)page_win.y1, (lv_coord_t)page_win.x2, (lv_coord_t)page_win.y2};
+        if (!epd_dirty_valid) {
+            lv_area_copy(&epd_dirty_area, &win);
+            epd_dirty_valid = true;
+        } else {
+            _lv_area_join(&epd_dirty_area, &epd_dirty_area, &win);
         }
     }
-    driver->EPD_DisplayPart(); // 局部刷新
+#endif
+
+    if (!epd_dirty_valid) {
+        lv_area_copy(&epd_dirty_area, area);
+        epd_dirty_valid = true;
+    } else {
+        _lv_area_join(&epd_dirty_area, &epd_dirty_area, area);
+    }
+
+    // 最后一块区域到达后，把合并后的窗口交给驱动后台刷新，LVGL 不必等待刷新波形结束
+    if (lv_disp_flush_is_last(drv)) {
+        driver->EPD_RefreshAsync(epd_dirty_area.x1, epd_dirty_area.y1, epd_dirty_area.x2, epd_dirty_area.y2,
+                                 ui_pending_cb, ui_pending_cb_arg, EPD_UPDATE_NORMAL, ui_pending_latency_ms);
+        epd_dirty_valid = false;
+        ui_pending_latency_ms = EPD_LATENCY_ANY;
+        ui_pending_cb = NULL;
+    }
     lv_disp_flush_ready(drv);
 }
 
@@ -188,55 +787,61 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
         ESP_LOGI(TAG, "MQTT Connected");
     } else if (event_id == MQTT_EVENT_DATA) {
         ESP_LOGI(TAG, "Data Received");
-        char *json_str = (char *)malloc(event->data_len + 1);
-        if (json_str) {
-            memcpy(json_str, event->data, event->data_len);
-            json_str[event->data_len] = 0;
-            cJSON *root = cJSON_Parse(json_str);
-            if (root) {
-                update_ui_from_json(root);
-                cJSON_Delete(root);
-            }
-            free(json_str);
+        static task_snapshot_t snap;    // 只在 MQTT 任务中使用
+        if (task_snapshot_decode(event->data, event->data_len, &snap)) {
+            task_mailbox_post(ui_mailbox, &snap);
         }
     }
 }
 
-static void update_time_task(void *arg) {
+// 共用时钟服务在分钟变化时回调 (时钟任务中), 文字未变时两条路径都不会触发刷新
+static void clock_minute_cb(const struct tm *now, void *arg) {
     // 增加buffer大小以容纳日期 "MM-DD HH:MM"
     char time_buf[32]; 
-    while (1) {
-        time_t now;
-        time(&now);
-        struct tm t_info;
-        localtime_r(&now, &t_info);
-        
-        // 格式化为：01-15 12:30
-        strftime(time_buf, sizeof(time_buf), "%m-%d %H:%M", &t_info);
-        
-        if (example_lvgl_lock(-1)) {
-            if(ui_time_label) lv_label_set_text(ui_time_label, time_buf);
-            example_lvgl_unlock();
-        }
-        // 10秒刷新一次，确保分钟变化及时显示
-        vTaskDelay(pdMS_TO_TICKS(10000)); 
+    // 格式化为：01-15 12:30
+    strftime(time_buf, sizeof(time_buf), "%m-%d %H:%M", now);
+    
+#if EPD_CLOCK_FAST_PATH
+    if (clock_active) {
+        clock_fast_update(time_buf);
+    } else if (example_lvgl_lock(-1)) {
+        if(ui_time_label) clock_activate(time_buf);
+        ui_mark_source(UI_SRC_CLOCK);
+        example_lvgl_unlock();
     }
+#else
+    if (ui_begin()) {
+        ui_set_text(ui_time_label, time_buf);
+        ui_commit(UI_SRC_CLOCK);
+    }
+#endif
 }
 
-static void example_increase_lvgl_tick(void *arg) {
-    lv_tick_inc(EXAMPLE_LVGL_TICK_PERIOD_MS);
-}
-
+// 事件驱动: 没有待重绘区域时暂停 LVGL 的刷新定时器, 任务一直阻塞到下一个 LVGL 定时器到期或 lvgl_wake() 通知
 static void example_lvgl_port_task(void *arg) {
-    uint32_t task_delay_ms = EXAMPLE_LVGL_TASK_MAX_DELAY_MS;
+    uint32_t wakeups = 0;
+    int64_t stats_start_us = esp_timer_get_time();
     for(;;) {
+        uint32_t task_delay_ms = LV_NO_TIMER_READY;
         if (example_lvgl_lock(-1)) {
             task_delay_ms = lv_timer_handler();
+            lv_disp_t *disp = lv_disp_get_default();
+            if (disp->inv_p == 0) {
+                lv_timer_pause(disp->refr_timer);
+            }
             example_lvgl_unlock();
         }
-        if (task_delay_ms > EXAMPLE_LVGL_TASK_MAX_DELAY_MS) task_delay_ms = EXAMPLE_LVGL_TASK_MAX_DELAY_MS;
-        else if (task_delay_ms < EXAMPLE_LVGL_TASK_MIN_DELAY_MS) task_delay_ms = EXAMPLE_LVGL_TASK_MIN_DELAY_MS;
-        vTaskDelay(pdMS_TO_TICKS(task_delay_ms));
+        TickType_t ticks = (task_delay_ms == LV_NO_TIMER_READY) ? portMAX_DELAY : pdMS_TO_TICKS(task_delay_ms);
+        ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+
+        // 每个统计周期打印一次唤醒次数 (折算为每小时)
+        wakeups++;
+        const int64_t now = esp_timer_get_time();
+        if (now - stats_start_us >= (int64_t)EXAMPLE_LVGL_STATS_PERIOD_S * 1000000) {
+            ESP_LOGI(TAG, "LVGL task: %llu wakeups/h", (unsigned long long)wakeups * 3600000000ULL / (now - stats_start_us));
+            wakeups = 0;
+            stats_start_us = now;
+        }
     }
 }
 
@@ -261,6 +866,15 @@ extern "C" void app_main(void) {
     ESP_ERROR_CHECK(esp_netif_init());
     ESP_ERROR_CHECK(esp_event_loop_create_default());
 
+#if CONFIG_PM_ENABLE
+    // 所有任务都阻塞时自动进入 light sleep, Wi-Fi 保持默认的 modem sleep
+    esp_pm_config_t pm_config = {};
+    pm_config.max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    pm_config.min_freq_mhz = 40;
+    pm_config.light_sleep_enable = true;
+    ESP_ERROR_CHECK(esp_pm_configure(&pm_config));
+#endif
+
     // 2. 硬件驱动初始化 (来自 user_app.h)
     user_app_init(); 
 
@@ -269,58 +883,87 @@ extern "C" void app_main(void) {
     static lv_disp_draw_buf_t disp_buf;
     static lv_disp_drv_t disp_drv;
     
+#if EPD_LVGL_RENDER_1BPP
+    // 与驱动共用 5000 字节的 1bpp 帧缓冲, LVGL 只经 set_px_cb 访问它, 省去两块 80KB 的 PSRAM 显存
+    epd_draw_stride = (driver->EPD_GetWidth() + 7) >> 3;
+    lv_disp_draw_buf_init(&disp_buf, driver->EPD_GetFrameBuffer(), NULL, EPD_WIDTH * EPD_HEIGHT);
+#else
     // PSRAM 分配显存
     lv_color_t *buffer_1 = (lv_color_t *)heap_caps_malloc(LVGL_SPIRAM_BUFF_LEN , MALLOC_CAP_SPIRAM);
     lv_color_t *buffer_2 = (lv_color_t *)heap_caps_malloc(LVGL_SPIRAM_BUFF_LEN , MALLOC_CAP_SPIRAM);
     lv_disp_draw_buf_init(&disp_buf, buffer_1, buffer_2, EPD_WIDTH * EPD_HEIGHT);
+#endif
 
     lv_disp_drv_init(&disp_drv);
-    disp_drv.hor_res = EPD_WIDTH;
-    disp_drv.ver_res = EPD_HEIGHT;
+    disp_drv.hor_res = driver->EPD_GetWidth();     // 方向由驱动处理, LVGL 不做软件旋转
+    disp_drv.ver_res = driver->EPD_GetHeight();
     disp_drv.flush_cb = example_lvgl_flush_cb;
+    disp_drv.rounder_cb = example_lvgl_rounder_cb;
+#if EPD_LVGL_RENDER_1BPP
+    disp_drv.set_px_cb = example_lvgl_set_px_cb;
+#endif
+    disp_drv.monitor_cb = example_lvgl_monitor_cb;
     disp_drv.draw_buf = &disp_buf;
-    disp_drv.full_refresh = 1; // 墨水屏通常需要 full refresh 标记
+    disp_drv.full_refresh = 0; // 只重绘无效区域，由 flush_cb 做窗口局部刷新
     lv_disp_drv_register(&disp_drv);
 
-    // 4. 定时器与任务
-    const esp_timer_create_args_t lvgl_tick_timer_args = {
-        .callback = &example_increase_lvgl_tick,
-        .arg = NULL,           
-        .dispatch_method = ESP_TIMER_TASK,
-        .name = "lvgl_tick",
-        .skip_unhandled_events = false  
-    };
-    esp_timer_handle_t lvgl_tick_timer = NULL;
-    ESP_ERROR_CHECK(esp_timer_create(&lvgl_tick_timer_args, &lvgl_tick_timer));
-    ESP_ERROR_CHECK(esp_timer_start_periodic(lvgl_tick_timer, EXAMPLE_LVGL_TICK_PERIOD_MS * 1000));
-
+    // 4. 锁与任务 (LVGL 时钟由 LV_TICK_CUSTOM 读 esp_timer_get_time(), 不再需要 5ms 周期定时器)
     lvgl_mux = xSemaphoreCreateMutex();
     
     // 5. 构建 UI (手动 + 中文字体)
     if(example_lvgl_lock(-1)) {
+#if EPD_GLYPH_CACHE
+        ui_font = glyph_cache_wrap(&ui_font_FontCN16);
+#endif
         init_manual_ui();
+        lv_obj_update_layout(lv_scr_act());
+        ui_register_pack_regions(lv_scr_act());
+#if EPD_CLOCK_FAST_PATH
+        clock_glyphs_init(&ui_font_FontCN16);
+#endif
+#if EPD_PAGE_CACHE
+        page_cache_init();
+#endif
         example_lvgl_unlock();
     }
     
     // 6. 启动 LVGL 线程
-    xTaskCreatePinnedToCore(example_lvgl_port_task, "LVGL", 8 * 1024, NULL, 4, NULL, 1);
+    xTaskCreatePinnedToCore(example_lvgl_port_task, "LVGL", 8 * 1024, NULL, 4, &lvgl_task_handle, 1);
 
-    // 7. 网络连接
+    // 【关键】设置中国时区 (CST-8 = UTC+8), 缓存快照的截止时间也按本地时间显示
+    setenv("TZ", "CST-8", 1);
+    tzset();
+
+    // 7. 视图任务: 上次保存的任务列表先显示出来 (标为过期), 不必等 WiFi/TLS/MQTT
+    ui_mailbox = task_mailbox_create();
+    assert(ui_mailbox);
+    xTaskCreate(ui_view_task, "ui_view", 4096, NULL, 5, NULL);
+    static task_snapshot_t cached;
+    if (task_snapshot_store_load(&cached)) {
+        task_mailbox_post(ui_mailbox, &cached);
+        boot_mark("cached tasks loaded");
+    }
+#if EPD_PAGE_CACHE
+    // 按键翻页
+    user_button_init();
+    xTaskCreate(page_button_task, "page_next", 3072, boot_groups, 6, NULL);
+    xTaskCreate(page_button_task, "page_prev", 3072, pwr_groups, 6, NULL);
+#endif
+
+    // 8. 网络连接
     ESP_ERROR_CHECK(example_connect()); // 连接 WiFi
+    boot_mark("network up");
     
-    // 8. 校时 (使用新 API + 时区设置)
+    // 9. 校时 (使用新 API)
     esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
     esp_sntp_setservername(0, "ntp.aliyun.com");
     esp_sntp_init();
     
-    // 【关键】设置中国时区 (CST-8 = UTC+8)
-    setenv("TZ", "CST-8", 1);
-    tzset();
-    
-    // 启动时间刷新任务
-    xTaskCreate(update_time_task, "time_task", 2048, NULL, 5, NULL);
+    // 启动分钟时钟服务 (与 Sparkbot 固件共用, 见 firmware/common)
+    ESP_ERROR_CHECK(clock_service_start(4096, 5));
+    clock_service_subscribe(clock_minute_cb, NULL);
 
-    // 9. 启动 MQTT
+    // 10. MQTT
     esp_mqtt_client_config_t mqtt_cfg = {};
     mqtt_cfg.broker.address.uri = EMQX_BROKER_URL;
     mqtt_cfg.credentials.username = EMQX_USERNAME;
@@ -33,9 +33,38 @@
 #define ESP32_I2C_SCL_PIN GPIO_NUM_48
 
 /*lvgl init*/
-#define EXAMPLE_LVGL_TICK_PERIOD_MS    5
-#define EXAMPLE_LVGL_TASK_MAX_DELAY_MS 500
-#define EXAMPLE_LVGL_TASK_MIN_DELAY_MS 100
+#define EXAMPLE_LVGL_STATS_PERIOD_S    3600 //LVGL 任务唤醒次数的统计周期, 时钟来自 esp_timer_get_time() (LV_TICK_CUSTOM)
+#define EPD_LVGL_RENDER_1BPP           1    //LVGL 直接画进驱动的 1bpp 帧缓冲; 0 则使用两块 RGB565 PSRAM 显存再转换
+#define EPD_PACK_DEFAULT_MODE          EPD_PACK_LUMA  //默认二值化方式, 图片区域另行指定 EPD_PACK_DITHER
+#define EPD_ROTATION                   EPD_ROT_0      //面板安装方向 (顺时针), 由驱动在二值化时处理
+#define EPD_MIRROR                     0              //1: 画面左右镜像
+#define EPD_CLOCK_FAST_PATH            1              //分钟时钟直接用 1bpp 数字字形画进帧缓冲, 不经过 LVGL 渲染
+#define EPD_PAGE_CACHE                 1              //任务列表按页预渲染到 PSRAM, 按键翻页只拷贝缓存并局部刷新 (需要 EPD_LVGL_RENDER_1BPP)
+#define EPD_GLYPH_CACHE                1              //标签用到的中文字形二值化成 1bpp 后按码位缓存 (LRU)
+#define EPD_GLYPH_CACHE_SLOTS          256            //缓存的字形数, 每个约 64 字节
+
+/*e-paper full refresh policy*/
+#define EPD_FULL_MAX_PARTIALS     200                           //连续局部刷新次数
+#define EPD_FULL_MAX_CHANGED_PX   (EPD_WIDTH * EPD_HEIGHT * 4)  //累计变化像素
+#define EPD_FULL_MAX_INTERVAL_S   (12 * 3600)                   //最长全刷间隔
+#define EPD_FULL_QUIET_HOUR       3                             //每天凌晨 3 点空闲时清洁全刷
+#define EPD_FULL_DEFER_PERCENT    75                            //可推迟的更新在达到阈值 75% 时顺便全刷
+#define EPD_PARTIAL_WAVEFORM      EPD_WF_PARTIAL                //默认局部波形, 纯文字界面可改为 EPD_WF_TEXT
+#define EPD_FAST_MAX_PX           0                             //变化像素不超过该值时用快速波形, 0 为关闭; 快速 LUT 尚未在实物上调校, 默认用原厂局部波形
+
+/*e-paper refresh coalescing*/
+#define EPD_COALESCE_MS           500                           //第一个刷新请求到达后最多等待多久, 期间的更新合并为一次刷新
+#define EPD_LATENCY_CLOCK_MS      2000                          //各更新来源能容忍的最长刷新延迟, 短于合并窗口时提前刷新
+#define EPD_LATENCY_TASKS_MS      300                           //任务列表和计数 (MQTT)
+#define EPD_LATENCY_PAGE_MS       0                             //按键翻页, 不等待合并
+
+/*e-paper power*/
+#define EPD_AUTO_SLEEP_MS         3000                          //刷新完成后空闲多久进入深睡, 0 关闭
+#define EPD_AUTO_SLEEP_RAIL_OFF   0                             //1: 深睡后同时关闭面板供电 (唤醒需完整初始化)
+
+/*e-paper frame persistence*/
+#define EPD_FRAME_STORE_LABEL     "epdframe"                    //保存最后一帧的 data 分区, 见 partitions.csv
+#define EPD_FRAME_STORE_MIN_S     300                           //两次保存的最小间隔 (秒), 控制 flash 擦写次数
 
 /*i2c dev*/
 #define I2C_RTC_DEV_Address        0x51
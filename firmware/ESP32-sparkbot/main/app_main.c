@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <assert.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <string.h>
@@ -10,15 +11,16 @@
 #include "esp_netif.h"
 #include "protocol_examples_common.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "mqtt_client.h"
 #include "esp_sntp.h"
-#include "freertos/semphr.h" // 引入互斥锁
 
 // --- UI 和 BSP 头文件 ---
 #include "ui.h"
-#include "cJSON.h"
 #include "esp_sparkbot_bsp.h"
 #include "bsp_board_extra.h"
+#include "clock_service.h"
+#include "task_model.h"
 // -----------------------
 
 // ================== 用户配置区域 (请修改此处) ==================
@@ -36,21 +38,21 @@
 // ============================================================
 
 #define EMQX_CA_PATH       "./emqxsl-ca.crt"
-#define MAX_TASKS          10 // 最大缓存任务数
+#define SCROLL_PERIOD_MS   3000 // 任务多于 3 条时的滚动间隔
 
 static const char *TAG = "feishu_screen_app";
 
-// --- 全局数据结构 ---
-typedef struct {
-    char summary[64];
-    char due_str[32];
-    bool is_valid;
-} task_item_t;
+// MQTT 任务解码出任务列表快照, 经 "最新者胜" 邮箱交给视图任务渲染 (最多缓存 TASK_MODEL_MAX_TASKS 条)
+static task_mailbox_t *s_ui_mailbox = NULL;
 
-static task_item_t g_tasks[MAX_TASKS]; 
-static int g_total_tasks = 0;          
-static int g_scroll_offset = 0;        
-static SemaphoreHandle_t xTaskDataMutex = NULL; 
+// 开机时间线 (esp_timer 启动后的毫秒数); 首屏指第一份任务列表 (缓存或实时) 交给 LVGL
+static bool s_boot_first_display = false;
+static bool s_boot_first_live = false;
+
+static void boot_mark(const char *stage)
+{
+    ESP_LOGI(TAG, "boot +%lld ms: %s", (long long)(esp_timer_get_time() / 1000), stage);
+}
 
 // 嵌入CA证书内容
 // 注意：这是 DigiCert Global Root G2 (EMQX Serverless 常用证书)
@@ -79,15 +81,6 @@ static const char *mqtt_ca_cert =
     "MrY=\n"
     "-----END CERTIFICATE-----\n";
 
-void safe_strncpy_ellipsis(char *dest, const char *src, size_t size) {
-    if (src == NULL) {
-        dest[0] = '\0';
-        return;
-    }
-    strncpy(dest, src, size - 1);
-    dest[size - 1] = '\0';
-}
-
 static void initialize_sntp(void)
 {
     ESP_LOGI(TAG, "Initializing SNTP");
@@ -106,33 +99,37 @@ void format_timestamp(time_t raw_time, char* buffer, size_t size) {
     strftime(buffer, size, "%m月%d日%H:%M", &t_info);
 }
 
-static void update_time_task(void *arg)
+// 分钟变化时由共用时钟服务回调; 文字没变就不碰 LVGL, 省掉大号数字的重绘
+static void clock_minute_cb(const struct tm *now, void *arg)
 {
+    static char last_buf[32];
     char time_buf[32];
-    vTaskDelay(pdMS_TO_TICKS(2000)); 
-    while (1) {
-        time_t now;
-        time(&now);
-        format_timestamp(now, time_buf, sizeof(time_buf));
+    strftime(time_buf, sizeof(time_buf), "%m月%d日%H:%M", now);
+    if (strcmp(time_buf, last_buf) == 0) {
+        return;
+    }
 
-        bsp_display_lock(0);
-        if (ui_time) {
-            lv_label_set_text(ui_time, time_buf);
-        }
-        bsp_display_unlock();
-        vTaskDelay(pdMS_TO_TICKS(10000)); 
+    bsp_display_lock(0);
+    if (ui_time) {
+        lv_label_set_text(ui_time, time_buf);
+        strcpy(last_buf, time_buf);
     }
+    bsp_display_unlock();
 }
 
-// --- 更新列表UI ---
-static void update_task_list_ui() {
+// --- 更新列表UI (视图任务中) ---
+static void update_task_list_ui(const task_snapshot_t *snap, int scroll_offset) {
+    // 开机读回的缓存快照半透明显示, 实时消息到达后恢复
+    const lv_opa_t opa = snap->stale ? LV_OPA_50 : LV_OPA_COVER;
+
     bsp_display_lock(0);
 
     // 更新总数
     if (ui_todonumber) {
         char count_buf[16];
-        sprintf(count_buf, "%d", g_total_tasks);
+        sprintf(count_buf, "%d", snap->count);
         lv_label_set_text(ui_todonumber, count_buf);
+        lv_obj_set_style_text_opa(ui_todonumber, opa, 0);
     }
     
     if(ui_Spinner2 && lv_obj_has_flag(ui_Spinner2, LV_OBJ_FLAG_HIDDEN)) {
@@ -144,24 +141,29 @@ static void update_task_list_ui() {
 
     for (int i = 0; i < 3; i++) {
         int task_idx = -1;
+        if (labels_info[i]) lv_obj_set_style_text_opa(labels_info[i], opa, 0);
+        if (labels_ddl[i])  lv_obj_set_style_text_opa(labels_ddl[i], opa, 0);
 
-        if (g_total_tasks > 3) {
+        if (snap->count > 3) {
             // 循环滚动
-            task_idx = (g_scroll_offset + i) % g_total_tasks;
+            task_idx = (scroll_offset + i) % snap->count;
         } else {
             // 静态显示
-            if (i < g_total_tasks) {
+            if (i < snap->count) {
                 task_idx = i;
             } else {
                 task_idx = -1; 
             }
         }
 
-        if (task_idx >= 0 && task_idx < g_total_tasks && g_tasks[task_idx].is_valid) {
-            if (labels_info[i]) lv_label_set_text(labels_info[i], g_tasks[task_idx].summary);
-            if (labels_ddl[i])  lv_label_set_text(labels_ddl[i],  g_tasks[task_idx].due_str);
+        if (task_idx >= 0 && task_idx < snap->count) {
+            const task_entry_t *e = &snap->items[task_idx];
+            char due_str[32];
+            format_timestamp((time_t)(e->due_ms / 1000), due_str, sizeof(due_str));
+            if (labels_info[i]) lv_label_set_text(labels_info[i], e->has_summary ? e->summary : "无标题");
+            if (labels_ddl[i])  lv_label_set_text(labels_ddl[i],  due_str);
         } else {
-            if (i == 0 && g_total_tasks == 0) {
+            if (i == 0 && snap->count == 0) {
                 if (labels_info[i]) lv_label_set_text(labels_info[i], "暂无任务");
                 if (labels_ddl[i])  lv_label_set_text(labels_ddl[i],  "00月00日00:00");
             } else {
@@ -174,25 +176,38 @@ static void update_task_list_ui() {
     bsp_display_unlock();
 }
 
-// --- 列表滚动控制 ---
-static void scroll_task(void *arg) {
-    while (1) {
-        vTaskDelay(pdMS_TO_TICKS(3000)); 
+// --- 视图任务: 渲染最新快照, 任务多于 3 条时循环滚动 ---
+static void ui_view_task(void *arg) {
+    static task_snapshot_t view;    // 当前显示的列表, 只在本任务中访问
+    int scroll_offset = 0;
+    task_mailbox_stats_t stats;
 
-        if (xSemaphoreTake(xTaskDataMutex, portMAX_DELAY) == pdTRUE) {
-            if (g_total_tasks > 3) {
-                g_scroll_offset++;
-                if (g_scroll_offset >= g_total_tasks) {
-                    g_scroll_offset = 0;
-                }
-                update_task_list_ui(); 
-            } else {
-                if (g_scroll_offset != 0) {
-                    g_scroll_offset = 0;
-                    update_task_list_ui();
+    while (1) {
+        if (task_mailbox_take(s_ui_mailbox, &view, pdMS_TO_TICKS(SCROLL_PERIOD_MS))) {
+            // 新列表从头显示; 渲染期间到达的中间快照已被邮箱丢弃
+            scroll_offset = 0;
+            update_task_list_ui(&view, scroll_offset);
+            task_mailbox_get_stats(s_ui_mailbox, &stats);
+            ESP_LOGI(TAG, "Updated List: %d tasks (snapshot %lu, queued %lu us, %lu dropped)", view.count,
+                     (unsigned long)view.seq, (unsigned long)stats.last_latency_us, (unsigned long)stats.dropped);
+            if (!s_boot_first_display) {
+                s_boot_first_display = true;
+                boot_mark(view.stale ? "first meaningful display (cached tasks)" : "first meaningful display (live tasks)");
+            }
+            if (!view.stale) {
+                if (!s_boot_first_live) {
+                    s_boot_first_live = true;
+                    boot_mark("live tasks on screen");
                 }
+                // 实时列表存进 NVS, 下次开机先显示它
+                task_snapshot_store_save(&view);
+            }
+        } else if (view.count > 3) {
+            scroll_offset++;
+            if (scroll_offset >= view.count) {
+                scroll_offset = 0;
             }
-            xSemaphoreGive(xTaskDataMutex);
+            update_task_list_ui(&view, scroll_offset);
         }
     }
 }
@@ -229,67 +244,13 @@ static void mqtt5_event_handler(void *handler_args, esp_event_base_t base, int32
     case MQTT_EVENT_DATA:
         if (event->topic && strncmp(event->topic, EMQX_TOPIC, event->topic_len) == 0) {
             ESP_LOGI(TAG, "Received Tasks Array");
-            
-            char *json_str = (char *)malloc(event->data_len + 1);
-            if (json_str) {
-                memcpy(json_str, event->data, event->data_len);
-                json_str[event->data_len] = '\0';
-                
-                cJSON *root = cJSON_Parse(json_str);
-                
-                if (xSemaphoreTake(xTaskDataMutex, portMAX_DELAY) == pdTRUE) {
-                    // [核心修改 1] 判断是否为数组
-                    if (cJSON_IsArray(root)) {
-                        ESP_LOGI(TAG, "Processing JSON Array...");
-                        
-                        // [核心修改 2] 先清空当前所有任务 (解决删除问题)
-                        g_total_tasks = 0;
-                        g_scroll_offset = 0;
-                        memset(g_tasks, 0, sizeof(g_tasks));
-
-                        int array_size = cJSON_GetArraySize(root);
-                        // 限制最大数量
-                        int count = (array_size > MAX_TASKS) ? MAX_TASKS : array_size;
-                        
-                        // [核心修改 3] 按顺序填充 (解决排序问题)
-                        // 因为服务器已经排好序了，我们只要按顺序读进来即可
-                        for (int i = 0; i < count; i++) {
-                            cJSON *item = cJSON_GetArrayItem(root, i);
-                            if (!item) continue;
-
-                            cJSON *summary = cJSON_GetObjectItem(item, "summary");
-                            cJSON *due = cJSON_GetObjectItem(item, "dueTimestamp");
-
-                            // 填充标题
-                            safe_strncpy_ellipsis(g_tasks[i].summary, 
-                                cJSON_IsString(summary) ? summary->valuestring : "无标题", 64);
-
-                            // 填充时间
-                            long long ts_ms = 0;
-                            if (cJSON_IsNumber(due)) ts_ms = (long long)due->valuedouble;
-                            else if (cJSON_IsString(due)) ts_ms = atoll(due->valuestring);
-                            
-                            format_timestamp((time_t)(ts_ms / 1000), g_tasks[i].due_str, 32);
-                            
-                            g_tasks[i].is_valid = true;
-                        }
-                        
-                        // 更新总数
-                        g_total_tasks = count;
-                        ESP_LOGI(TAG, "Updated List: %d tasks", g_total_tasks);
-                    } 
-                    else {
-                        ESP_LOGW(TAG, "Received payload is not a JSON Array!");
-                    }
-
-                    // 刷新UI
-                    update_task_list_ui();
-                    
-                    xSemaphoreGive(xTaskDataMutex);
-                }
 
-                cJSON_Delete(root);
-                free(json_str);
+            // 只解码并投递, 不等显示锁; 服务器已经排好序, 按顺序读进来即可
+            static task_snapshot_t snap;    // 只在 MQTT 任务中使用
+            if (task_snapshot_decode(event->data, event->data_len, &snap)) {
+                task_mailbox_post(s_ui_mailbox, &snap);
+            } else {
+                ESP_LOGW(TAG, "Received payload is not a JSON Array!");
             }
         }
         break;
@@ -344,7 +305,8 @@ void app_main(void)
 {
     ESP_LOGI(TAG, "[APP] Startup..");
     
-    xTaskDataMutex = xSemaphoreCreateMutex();
+    s_ui_mailbox = task_mailbox_create();
+    assert(s_ui_mailbox);
 
     esp_err_t err = nvs_flash_init();
     if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -389,13 +351,22 @@ void app_main(void)
 
     bsp_touch_button_create(button_handler);
 
+    // 上次保存的任务列表先显示出来 (半透明表示过期), 不必等 WiFi/TLS/MQTT
+    xTaskCreate(ui_view_task, "ui_view", 4096, NULL, 5, NULL);
+    static task_snapshot_t cached;
+    if (task_snapshot_store_load(&cached)) {
+        task_mailbox_post(s_ui_mailbox, &cached);
+        boot_mark("cached tasks loaded");
+    }
+
     // 连接 WiFi (通常在 menuconfig 中配置 SSID/密码，或在此处硬编码)
     // 确保您已在 sdkconfig 中配置了 WiFi 或修改 protocol_examples_common.h
     ESP_ERROR_CHECK(example_connect());
+    boot_mark("network up");
     initialize_sntp();
 
     mqtt5_app_start();
     
-    xTaskCreate(update_time_task, "time_task", 2048, NULL, 5, NULL);
-    xTaskCreate(scroll_task, "scroll_task", 2048, NULL, 5, NULL);
+    ESP_ERROR_CHECK(clock_service_start(3072, 5));
+    clock_service_subscribe(clock_minute_cb, NULL);
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /**< _cplusplus */
+
+#define CLOCK_SERVICE_MAX_SUBS    4     /* 最多订阅者数 */
+#define CLOCK_SERVICE_MARGIN_MS   20    /* 在分钟边界之后多睡一点, 避免因时钟抖动提前醒来 */
+
+/* 本地时间进入新的一分钟时调用, 运行在时钟任务中; now 为当前本地时间 */
+typedef void (*clock_minute_cb_t)(const struct tm *now, void *arg);
+
+typedef struct {
+    uint32_t wakeups;       /* 时钟任务醒来次数 */
+    uint32_t minutes;       /* 分发过的分钟变化次数 */
+    uint32_t resyncs;       /* SNTP 校时后重新对齐的次数 */
+} clock_service_stats_t;
+
+/*
+ * 两个固件共用的分钟时钟: 一个任务睡到下一个分钟边界, 分钟变化时通知订阅者.
+ * 注册 SNTP 校时回调, 时间被调整后立即重新对齐; 需在 sntp_init() 之前或之后调用均可.
+ */
+esp_err_t clock_service_start(uint32_t stack_size, int priority);
+
+/* 订阅分钟变化, 订阅时立即以当前时间回调一次 (在时钟任务中) */
+bool clock_service_subscribe(clock_minute_cb_t cb, void *arg);
+
+/* 系统时间被外部修改 (SNTP 之外, 如 RTC 写入) 后调用, 让时钟任务重新对齐 */
+void clock_service_resync(void);
+
+void clock_service_get_stats(clock_service_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /**< _cplusplus */
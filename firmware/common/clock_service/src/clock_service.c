@@ -0,0 +1,116 @@
+#include <string.h>
+#include <sys/time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_sntp.h"
+#include "clock_service.h"
+
+static const char *TAG = "clock_service";
+
+typedef struct {
+    clock_minute_cb_t cb;
+    void *arg;
+    bool fresh;             /* 刚订阅, 还没收到过回调 */
+} clock_sub_t;
+
+static TaskHandle_t s_task = NULL;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static clock_sub_t s_subs[CLOCK_SERVICE_MAX_SUBS];
+static int s_sub_count = 0;
+static clock_service_stats_t s_stats;
+
+/* 分钟序号 (Unix 时间 / 60); 时区偏移都是整分钟, 本地时间与 UTC 在同一时刻换分钟 */
+static int64_t minute_of(const struct timeval *tv)
+{
+    return (int64_t)tv->tv_sec / 60;
+}
+
+/* 到下一个分钟边界的毫秒数 */
+static uint32_t ms_to_next_minute(const struct timeval *tv)
+{
+    const int64_t us_into_minute = ((int64_t)tv->tv_sec % 60) * 1000000 + tv->tv_usec;
+    return (uint32_t)((60000000 - us_into_minute) / 1000) + CLOCK_SERVICE_MARGIN_MS;
+}
+
+static void clock_sntp_sync_cb(struct timeval *tv)
+{
+    clock_service_resync();
+}
+
+static void clock_task(void *arg)
+{
+    int64_t last_minute = -1;
+    for (;;) {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        const int64_t minute = minute_of(&tv);
+        const bool changed = (minute != last_minute);
+        last_minute = minute;
+
+        struct tm now;
+        time_t t = tv.tv_sec;
+        localtime_r(&t, &now);
+        if (changed) {
+            s_stats.minutes++;
+        }
+        for (int i = 0; i < CLOCK_SERVICE_MAX_SUBS; i++) {
+            taskENTER_CRITICAL(&s_lock);
+            clock_sub_t sub = s_subs[i];
+            s_subs[i].fresh = false;
+            taskEXIT_CRITICAL(&s_lock);
+            if (sub.cb && (changed || sub.fresh)) {
+                sub.cb(&now, sub.arg);
+            }
+        }
+
+        /* 校时或新订阅会提前唤醒, 之后重新计算到分钟边界的时间 */
+        gettimeofday(&tv, NULL);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms_to_next_minute(&tv)));
+        s_stats.wakeups++;
+    }
+}
+
+esp_err_t clock_service_start(uint32_t stack_size, int priority)
+{
+    if (s_task) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (xTaskCreate(clock_task, "clock_svc", stack_size, NULL, priority, &s_task) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    sntp_set_time_sync_notification_cb(clock_sntp_sync_cb);
+    ESP_LOGI(TAG, "started");
+    return ESP_OK;
+}
+
+bool clock_service_subscribe(clock_minute_cb_t cb, void *arg)
+{
+    bool ok = false;
+    taskENTER_CRITICAL(&s_lock);
+    if (s_sub_count < CLOCK_SERVICE_MAX_SUBS) {
+        s_subs[s_sub_count].cb = cb;
+        s_subs[s_sub_count].arg = arg;
+        s_subs[s_sub_count].fresh = true;
+        s_sub_count++;
+        ok = true;
+    }
+    taskEXIT_CRITICAL(&s_lock);
+    if (ok && s_task) {
+        xTaskNotifyGive(s_task);
+    }
+    return ok;
+}
+
+void clock_service_resync(void)
+{
+    s_stats.resyncs++;
+    if (s_task) {
+        xTaskNotifyGive(s_task);
+    }
+}
+
+void clock_service_get_stats(clock_service_stats_t *stats)
+{
+    *stats = s_stats;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /**< _cplusplus */
+
+#define TASK_MODEL_MAX_TASKS     10     /* 快照中最多保存的任务数 */
+#define TASK_MODEL_SUMMARY_LEN   64     /* 标题按 UTF-8 字符边界截断 */
+
+typedef struct {
+    char summary[TASK_MODEL_SUMMARY_LEN];
+    bool has_summary;       /* JSON 中有字符串类型的 summary */
+    int64_t due_ms;         /* 截止时间 (Unix 毫秒), 0 表示无截止 */
+} task_entry_t;
+
+/* MQTT 一条消息解码后的完整任务列表; 投递后只读, 视图拿到的是自己的副本 */
+typedef struct {
+    uint32_t seq;           /* 投递序号 */
+    int64_t posted_us;      /* 投递时间, 用于统计排队延迟 */
+    int total;              /* 服务器发来的任务总数, 可能大于 count */
+    int count;
+    bool stale;             /* 开机时从 flash 读回的上次快照, 实时消息到达前显示为过期 */
+    task_entry_t items[TASK_MODEL_MAX_TASKS];
+} task_snapshot_t;
+
+/* 解析服务器下发的任务数组 (已按顺序排好); 不是数组时返回 false */
+bool task_snapshot_decode(const char *json, int len, task_snapshot_t *out);
+
+/*
+ * 最后一份快照以紧凑的二进制形式 (版本 + CRC) 存进 NVS, 开机时先显示它, 不必等 WiFi/TLS/MQTT.
+ * 只在视图任务中调用; 内容与已保存的相同时不写 flash.
+ */
+bool task_snapshot_store_save(const task_snapshot_t *snap);
+/* 没有保存过, 或版本/CRC 不符时返回 false; 读出的快照 stale 为 true */
+bool task_snapshot_store_load(task_snapshot_t *out);
+
+typedef struct {
+    uint32_t posted;
+    uint32_t taken;
+    uint32_t dropped;           /* 还没被取走就被更新的快照覆盖 */
+    uint32_t last_latency_us;   /* 投递到被视图取走 */
+    uint32_t max_latency_us;
+} task_mailbox_stats_t;
+
+typedef struct task_mailbox task_mailbox_t;
+
+/*
+ * 单槽 "最新者胜" 邮箱: MQTT 任务投递快照从不阻塞在渲染上, 视图任务只渲染最新的一份,
+ * 中间来不及渲染的快照直接丢弃并计数.
+ */
+task_mailbox_t *task_mailbox_create(void);
+void task_mailbox_post(task_mailbox_t *mb, const task_snapshot_t *snap);
+/* 等待新快照, 超时返回 false */
+bool task_mailbox_take(task_mailbox_t *mb, task_snapshot_t *out, TickType_t wait);
+void task_mailbox_get_stats(task_mailbox_t *mb, task_mailbox_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif /**< _cplusplus */
@@ -0,0 +1,125 @@
+#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "cJSON.h"
+#include "task_model.h"
+
+static const char *TAG = "task_model";
+
+struct task_mailbox {
+    SemaphoreHandle_t lock;     /* 只在拷贝快照时持有 */
+    SemaphoreHandle_t ready;    /* 二值信号量, 槽中有未取走的快照 */
+    bool full;
+    uint32_t seq;
+    task_snapshot_t slot;
+    task_mailbox_stats_t stats;
+};
+
+/* 截断到 size-1 字节以内, 不拆开 UTF-8 多字节字符 */
+static void copy_utf8(char *dst, const char *src, size_t size)
+{
+    size_t n = strlen(src);
+    if (n >= size) {
+        n = size - 1;
+        while (n > 0 && ((unsigned char)src[n] & 0xC0) == 0x80) {
+            n--;
+        }
+    }
+    memcpy(dst, src, n);
+    dst[n] = '\0';
+}
+
+bool task_snapshot_decode(const char *json, int len, task_snapshot_t *out)
+{
+    cJSON *root = cJSON_ParseWithLength(json, len);
+    if (!cJSON_IsArray(root)) {
+        cJSON_Delete(root);
+        return false;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->total = cJSON_GetArraySize(root);
+    int i = 0;
+    cJSON *item = NULL;
+    cJSON_ArrayForEach(item, root) {
+        if (i >= TASK_MODEL_MAX_TASKS) {
+            break;
+        }
+        task_entry_t *e = &out->items[i++];
+        cJSON *summary = cJSON_GetObjectItem(item, "summary");
+        cJSON *due = cJSON_GetObjectItem(item, "dueTimestamp");
+        if (cJSON_IsString(summary)) {
+            copy_utf8(e->summary, summary->valuestring, sizeof(e->summary));
+            e->has_summary = true;
+        }
+        if (cJSON_IsNumber(due)) {
+            e->due_ms = (int64_t)due->valuedouble;
+        } else if (cJSON_IsString(due)) {
+            e->due_ms = atoll(due->valuestring);
+        }
+    }
+    out->count = i;
+    cJSON_Delete(root);
+    return true;
+}
+
+task_mailbox_t *task_mailbox_create(void)
+{
+    task_mailbox_t *mb = calloc(1, sizeof(task_mailbox_t));
+    if (mb == NULL) {
+        return NULL;
+    }
+    mb->lock = xSemaphoreCreateMutex();
+    mb->ready = xSemaphoreCreateBinary();
+    assert(mb->lock && mb->ready);
+    return mb;
+}
+
+void task_mailbox_post(task_mailbox_t *mb, const task_snapshot_t *snap)
+{
+    xSemaphoreTake(mb->lock, portMAX_DELAY);
+    if (mb->full) {
+        mb->stats.dropped++;
+    }
+    mb->slot = *snap;
+    mb->slot.seq = ++mb->seq;
+    mb->slot.posted_us = esp_timer_get_time();
+    mb->full = true;
+    mb->stats.posted++;
+    xSemaphoreGive(mb->lock);
+    xSemaphoreGive(mb->ready);
+}
+
+bool task_mailbox_take(task_mailbox_t *mb, task_snapshot_t *out, TickType_t wait)
+{
+    if (xSemaphoreTake(mb->ready, wait) != pdTRUE) {
+        return false;
+    }
+    xSemaphoreTake(mb->lock, portMAX_DELAY);
+    const bool got = mb->full;
+    if (got) {
+        *out = mb->slot;
+        mb->full = false;
+        const uint32_t latency = (uint32_t)(esp_timer_get_time() - out->posted_us);
+        mb->stats.taken++;
+        mb->stats.last_latency_us = latency;
+        if (latency > mb->stats.max_latency_us) {
+            mb->stats.max_latency_us = latency;
+        }
+        ESP_LOGD(TAG, "snapshot %lu taken after %lu us, %lu dropped so far",
+                 (unsigned long)out->seq, (unsigned long)latency, (unsigned long)mb->stats.dropped);
+    }
+    xSemaphoreGive(mb->lock);
+    return got;
+}
+
+void task_mailbox_get_stats(task_mailbox_t *mb, task_mailbox_stats_t *stats)
+{
+    xSemaphoreTake(mb->lock, portMAX_DELAY);
+    *stats = mb->stats;
+    xSemaphoreGive(mb->lock);
+}
@@ -0,0 +1,160 @@
+#include <string.h>
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+#include "task_model.h"
+
+static const char *TAG = "task_store";
+
+#define STORE_NAMESPACE  "task_model"
+#define STORE_KEY        "snapshot"
+#define STORE_MAGIC      0x4B534154     /* "TASK" */
+#define STORE_VERSION    1
+
+/* 头之后依次是 count 条记录: due_ms (8 字节, 小端) + flags (1) + 标题长度 (1) + 标题 (不含结尾 0) */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t len;           /* 头之后的字节数 */
+    int32_t total;
+    uint8_t count;
+    uint8_t reserved[3];
+    uint32_t crc;           /* 整个 blob, 计算时本字段按 0 */
+} store_hdr_t;
+
+#define STORE_ENTRY_MAX  (8 + 1 + 1 + TASK_MODEL_SUMMARY_LEN - 1)
+#define STORE_MAX        (sizeof(store_hdr_t) + TASK_MODEL_MAX_TASKS * STORE_ENTRY_MAX)
+#define ENTRY_HAS_SUMMARY 0x01
+
+static uint32_t s_saved_crc;    /* 已在 flash 中的内容, 相同时跳过写入 */
+static bool s_saved_valid;
+
+static size_t encode(const task_snapshot_t *snap, uint8_t *buf)
+{
+    store_hdr_t hdr = {
+        .magic = STORE_MAGIC,
+        .version = STORE_VERSION,
+        .total = snap->total,
+        .count = (uint8_t)snap->count,
+    };
+    uint8_t *p = buf + sizeof(hdr);
+    for (int i = 0; i < snap->count; i++) {
+        const task_entry_t *e = &snap->items[i];
+        const size_t n = strnlen(e->summary, TASK_MODEL_SUMMARY_LEN - 1);
+        const uint64_t due = (uint64_t)e->due_ms;
+        for (int b = 0; b < 8; b++) {
+            *p++ = (uint8_t)(due >> (8 * b));
+        }
+        *p++ = e->has_summary ? ENTRY_HAS_SUMMARY : 0;
+        *p++ = (uint8_t)n;
+        memcpy(p, e->summary, n);
+        p += n;
+    }
+    hdr.len = (uint16_t)(p - buf - sizeof(hdr));
+    memcpy(buf, &hdr, sizeof(hdr));
+    hdr.crc = esp_rom_crc32_le(0, buf, p - buf);
+    memcpy(buf, &hdr, sizeof(hdr));
+    return p - buf;
+}
+
+static bool decode(uint8_t *buf, size_t len, task_snapshot_t *out, uint32_t *crc_out)
+{
+    store_hdr_t hdr;
+    if (len < sizeof(hdr)) {
+        return false;
+    }
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (hdr.magic != STORE_MAGIC || hdr.version != STORE_VERSION || sizeof(hdr) + hdr.len != len ||
+        hdr.count > TASK_MODEL_MAX_TASKS) {
+        return false;
+    }
+    const uint32_t crc = hdr.crc;
+    hdr.crc = 0;
+    memcpy(buf, &hdr, sizeof(hdr));
+    if (esp_rom_crc32_le(0, buf, len) != crc) {
+        return false;
+    }
+
+    memset(out, 0, sizeof(*out));
+    const uint8_t *p = buf + sizeof(hdr);
+    const uint8_t *end = buf + len;
+    for (int i = 0; i < hdr.count; i++) {
+        task_entry_t *e = &out->items[i];
+        if (end - p < 10) {
+            return false;
+        }
+        uint64_t due = 0;
+        for (int b = 0; b < 8; b++) {
+            due |= (uint64_t)*p++ << (8 * b);
+        }
+        e->due_ms = (int64_t)due;
+        e->has_summary = (*p++ & ENTRY_HAS_SUMMARY) != 0;
+        const size_t n = *p++;
+        if (n >= TASK_MODEL_SUMMARY_LEN || (size_t)(end - p) < n) {
+            return false;
+        }
+        memcpy(e->summary, p, n);
+        p += n;
+    }
+    out->total = hdr.total;
+    out->count = hdr.count;
+    out->stale = true;
+    *crc_out = crc;
+    return true;
+}
+
+bool task_snapshot_store_save(const task_snapshot_t *snap)
+{
+    uint8_t buf[STORE_MAX];
+    const size_t len = encode(snap, buf);
+    store_hdr_t hdr;
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (s_saved_valid && hdr.crc == s_saved_crc) {
+        return true;
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(STORE_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(nvs, STORE_KEY, buf, len);
+        if (err == ESP_OK) {
+            err = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Save failed: %s", esp_err_to_name(err));
+        return false;
+    }
+    s_saved_crc = hdr.crc;
+    s_saved_valid = true;
+    ESP_LOGI(TAG, "Saved %d task(s), %u bytes", snap->count, (unsigned)len);
+    return true;
+}
+
+bool task_snapshot_store_load(task_snapshot_t *out)
+{
+    uint8_t buf[STORE_MAX];
+    size_t len = sizeof(buf);
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(STORE_NAMESPACE, NVS_READONLY, &nvs);
+    if (err != ESP_OK) {
+        return false;
+    }
+    err = nvs_get_blob(nvs, STORE_KEY, buf, &len);
+    nvs_close(nvs);
+    if (err != ESP_OK) {
+        if (err != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGW(TAG, "Load failed: %s", esp_err_to_name(err));
+        }
+        return false;
+    }
+    uint32_t crc;
+    if (!decode(buf, len, out, &crc)) {
+        ESP_LOGW(TAG, "Stored snapshot rejected (version or CRC mismatch)");
+        return false;
+    }
+    s_saved_crc = crc;
+    s_saved_valid = true;
+    return true;
+}